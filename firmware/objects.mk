@@ -17,6 +17,9 @@ ifdef FW_TEXT_START
 firmware-genflags-y += -DFW_TEXT_START=$(FW_TEXT_START)
 endif
 
+firmware-genflags-$(FW_TRAP_VECTORED) += -DFW_TRAP_VECTORED
+firmware-genflags-$(FW_TRAP_FAST_SET_TIMER) += -DFW_TRAP_FAST_SET_TIMER
+
 firmware-bins-$(FW_DYNAMIC) += fw_dynamic.bin
 
 firmware-bins-$(FW_JUMP) += fw_jump.bin
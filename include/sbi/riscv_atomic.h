@@ -38,6 +38,17 @@ unsigned int atomic_raw_xchg_uint(volatile unsigned int *ptr,
 
 unsigned long atomic_raw_xchg_ulong(volatile unsigned long *ptr,
 				    unsigned long newval);
+
+/**
+ * Compare and exchange any address and return the old value.
+ * @ptr: Address to modify
+ * @oldval: Expected value
+ * @newval: Value stored if the old value matches @oldval
+ */
+unsigned long atomic_raw_cmpxchg_ulong(volatile unsigned long *ptr,
+				       unsigned long oldval,
+				       unsigned long newval);
+
 /**
  * Set a bit in an atomic variable and return the new value.
  * @nr : Bit to set.
@@ -54,17 +65,25 @@ int atomic_set_bit(int nr, atomic_t *atom);
 int atomic_clear_bit(int nr, atomic_t *atom);
 
 /**
- * Set a bit in any address and return the new value .
+ * Set a bit in any address and return the old value of its word.
  * @nr : Bit to set.
  * @addr: Address to modify
  */
-int atomic_raw_set_bit(int nr, volatile unsigned long *addr);
+unsigned long atomic_raw_set_bit(int nr, volatile unsigned long *addr);
 
 /**
- * Clear a bit in any address and return the new value .
- * @nr : Bit to set.
+ * Clear a bit in any address and return the old value of its word.
+ * @nr : Bit to clear.
+ * @addr: Address to modify
+ */
+unsigned long atomic_raw_clear_bit(int nr, volatile unsigned long *addr);
+
+/**
+ * OR a mask into any address and return the old value.
+ * @mask: Bits to set.
  * @addr: Address to modify
  */
-int atomic_raw_clear_bit(int nr, volatile unsigned long *addr);
+unsigned long atomic_raw_fetch_or_ulong(unsigned long mask,
+					volatile unsigned long *addr);
 
 #endif
@@ -102,6 +102,9 @@
 #define SIP_SSIP			MIP_SSIP
 #define SIP_STIP			MIP_STIP
 
+#define MTVEC_MODE_DIRECT		_UL(0)
+#define MTVEC_MODE_VECTORED		_UL(1)
+
 #define PRV_U				_UL(0)
 #define PRV_S				_UL(1)
 #define PRV_M				_UL(3)
@@ -17,6 +17,9 @@
 #define SBI_ECALL_VERSION_MINOR		2
 #define SBI_OPENSBI_IMPID		1
 
+/* Maximum number of registered ecall extensions */
+#define SBI_ECALL_MAX_EXTENSIONS	32
+
 struct sbi_trap_regs;
 struct sbi_trap_info;
 
@@ -36,6 +39,7 @@ extern struct sbi_ecall_extension ecall_time;
 extern struct sbi_ecall_extension ecall_rfence;
 extern struct sbi_ecall_extension ecall_ipi;
 extern struct sbi_ecall_extension ecall_vendor;
+extern struct sbi_ecall_extension ecall_stats;
 extern struct sbi_ecall_extension ecall_hsm;
 
 u16 sbi_ecall_version_major(void);
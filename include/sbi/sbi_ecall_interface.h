@@ -62,6 +62,14 @@
 #define SBI_HSM_HART_STATUS_START_PENDING	0x2
 #define SBI_HSM_HART_STATUS_STOP_PENDING	0x3
 
+/* SBI function IDs for OpenSBI STATS firmware extension */
+#define SBI_EXT_STATS_TLB_NUM_WORDS		0x0
+#define SBI_EXT_STATS_TLB_READ			0x1
+#define SBI_EXT_STATS_TLB_RESET			0x2
+#define SBI_EXT_STATS_IPI_NUM_WORDS		0x3
+#define SBI_EXT_STATS_IPI_READ			0x4
+#define SBI_EXT_STATS_IPI_RESET			0x5
+
 #define SBI_SPEC_VERSION_MAJOR_OFFSET		24
 #define SBI_SPEC_VERSION_MAJOR_MASK		0x7f
 #define SBI_SPEC_VERSION_MINOR_MASK		0xffffff
@@ -69,6 +77,7 @@
 #define SBI_EXT_VENDOR_END			0x09FFFFFF
 #define SBI_EXT_FIRMWARE_START			0x0A000000
 #define SBI_EXT_FIRMWARE_END			0x0AFFFFFF
+#define SBI_EXT_STATS				0x0A535453
 /* clang-format on */
 
 #endif
@@ -22,9 +22,11 @@ enum sbi_hart_features {
 	SBI_HART_HAS_MCOUNTEREN = (1 << 2),
 	/** HART has timer csr implementation in hardware */
 	SBI_HART_HAS_TIME = (1 << 3),
+	/** HART has Svinval extension */
+	SBI_HART_HAS_SVINVAL = (1 << 4),
 
 	/** Last index of Hart features*/
-	SBI_HART_HAS_LAST_FEATURE = SBI_HART_HAS_TIME,
+	SBI_HART_HAS_LAST_FEATURE = SBI_HART_HAS_SVINVAL,
 };
 
 struct sbi_scratch;
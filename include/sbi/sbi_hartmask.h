@@ -17,9 +17,12 @@
  *
  * The hartmask is indexed using physical HART id so this define
  * also represents the maximum number of HART ids generic OpenSBI
- * can handle.
+ * can handle. Platforms can override it at build time through the
+ * PLATFORM_HART_COUNT_MAX make variable.
  */
+#ifndef SBI_HARTMASK_MAX_BITS
 #define SBI_HARTMASK_MAX_BITS		128
+#endif
 
 /** Representation of hartmask */
 struct sbi_hartmask {
@@ -134,8 +137,43 @@ static inline void sbi_hartmask_xor(struct sbi_hartmask *dstp,
 		   sbi_hartmask_bits(src2p), SBI_HARTMASK_MAX_BITS);
 }
 
+/**
+ * Find the first HART in hartmask starting from a HART id
+ * @param m the hartmask pointer
+ * @param h HART id to start from
+ * @return HART id or SBI_HARTMASK_MAX_BITS if there is none
+ */
+static inline u32 sbi_hartmask_next_hart(const struct sbi_hartmask *m, u32 h)
+{
+	u32 i = BIT_WORD(h);
+	unsigned long word;
+
+	if (SBI_HARTMASK_MAX_BITS <= h)
+		return SBI_HARTMASK_MAX_BITS;
+
+	word = m->bits[i] & BITMAP_FIRST_WORD_MASK(h);
+	while (!word) {
+		if (BITS_TO_LONGS(SBI_HARTMASK_MAX_BITS) <= ++i)
+			return SBI_HARTMASK_MAX_BITS;
+		word = m->bits[i];
+	}
+
+	return i * BITS_PER_LONG + __ffs(word);
+}
+
 /** Iterate over each HART in hartmask */
-#define sbi_hartmask_for_each_hart(__h, __m)	\
-	for_each_set_bit(__h, (__m)->bits, SBI_HARTMASK_MAX_BITS)
+#define sbi_hartmask_for_each_hart(__h, __m)				\
+	for ((__h) = sbi_hartmask_next_hart((__m), 0);			\
+	     (__h) < SBI_HARTMASK_MAX_BITS;				\
+	     (__h) = sbi_hartmask_next_hart((__m), (__h) + 1))
+
+/**
+ * Iterate over each set bit of a scalar hart mask. The mask is
+ * consumed by the loop.
+ * @param __i index of the set bit relative to the hart base
+ * @param __m the scalar hart mask
+ */
+#define sbi_hmask_for_each_bit(__i, __m)				\
+	for (; (__m) && ((__i) = __ffs(__m), 1); (__m) &= (__m) - 1)
 
 #endif
@@ -33,4 +33,28 @@ void __sbi_hfence_vvma_va(unsigned long va);
 
 /** Invalidate all possible Stage2 TLBs */
 void __sbi_hfence_vvma_all(void);
+
+/** Order prior stores before following Svinval invalidations */
+void __sbi_sfence_w_inval(void);
+
+/** Order prior Svinval invalidations before following implicit accesses */
+void __sbi_sfence_inval_ir(void);
+
+/** Svinval: Invalidate TLB entries for given virtual address and ASID */
+void __sbi_sinval_vma_asid_va(unsigned long asid, unsigned long va);
+
+/** Svinval: Invalidate TLB entries for given virtual address */
+void __sbi_sinval_vma_va(unsigned long va);
+
+/** Svinval: Invalidate Stage2 TLBs for given VMID and guest address */
+void __sbi_hinval_gvma_vmid_gpa(unsigned long vmid, unsigned long gpa);
+
+/** Svinval: Invalidate Stage2 TLBs for given guest physical address */
+void __sbi_hinval_gvma_gpa(unsigned long gpa);
+
+/** Svinval: Invalidate unified TLB entries for given ASID and guest VA */
+void __sbi_hinval_vvma_asid_va(unsigned long asid, unsigned long va);
+
+/** Svinval: Invalidate unified TLB entries for given guest VA */
+void __sbi_hinval_vvma_va(unsigned long va);
 #endif
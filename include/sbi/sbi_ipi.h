@@ -16,10 +16,48 @@
 
 #define SBI_IPI_EVENT_MAX			__riscv_xlen
 
+#define SBI_IPI_CALL_FIFO_NUM_ENTRIES		8
+
+/* Number of IPI events, in creation order, with latency statistics */
+#define SBI_IPI_LAT_EVENTS			6
+
+/* Number of log2 buckets in IPI latency histograms */
+#define SBI_IPI_HIST_BUCKETS			12
+
 /* clang-format on */
 
 struct sbi_scratch;
 
+/**
+ * Function run on remote HARTs by sbi_ipi_call_many(). It returns zero
+ * on success and a negative SBI error code otherwise.
+ */
+typedef int (*sbi_ipi_call_fn)(void *arg);
+
+/** Per-HART latency statistics of one IPI event */
+struct sbi_ipi_event_stats {
+	/** Events processed by this HART */
+	unsigned long count;
+	/** Timer ticks from the oldest pending send until this HART took it */
+	unsigned long delivery_hist[SBI_IPI_HIST_BUCKETS];
+	/** Cycles this HART spent in the process callback */
+	unsigned long handler_hist[SBI_IPI_HIST_BUCKETS];
+};
+
+/** Per-HART IPI statistics */
+struct sbi_ipi_stats {
+	/** Doorbells rung by this HART */
+	unsigned long doorbell_sent;
+	/** Doorbells skipped by this HART as the target had events pending */
+	unsigned long doorbell_saved;
+	/** Latency statistics of the first SBI_IPI_LAT_EVENTS events */
+	struct sbi_ipi_event_stats event[SBI_IPI_LAT_EVENTS];
+};
+
+/** Number of unsigned long words in struct sbi_ipi_stats */
+#define SBI_IPI_STATS_WORDS	\
+	(sizeof(struct sbi_ipi_stats) / sizeof(unsigned long))
+
 /** IPI event operations or callbacks */
 struct sbi_ipi_event_ops {
 	/** Name of the IPI event operations */
@@ -35,9 +73,9 @@ struct sbi_ipi_event_ops {
 			u32 remote_hartid, void *data);
 
 	/**
-	 * Sync callback to wait for remote HART
-	 * Note: This is an optional callback and it is called just after
-	 * triggering IPI to remote HART.
+	 * Sync callback to wait for remote HARTs
+	 * Note: This is an optional callback and it is called only once
+	 * after triggering IPI to all remote HARTs.
 	 */
 	void (* sync)(struct sbi_scratch *scratch);
 
@@ -61,8 +99,18 @@ void sbi_ipi_clear_smode(void);
 
 int sbi_ipi_send_halt(ulong hmask, ulong hbase);
 
+int sbi_ipi_call_many(ulong hmask, ulong hbase,
+		      sbi_ipi_call_fn fn, void *arg, bool wait);
+
 void sbi_ipi_process(void);
 
+int sbi_ipi_stats_read(u32 hartid, unsigned long index,
+		       unsigned long *out_val);
+
+int sbi_ipi_stats_reset(u32 hartid);
+
+void sbi_ipi_stats_dump(struct sbi_scratch *scratch);
+
 int sbi_ipi_init(struct sbi_scratch *scratch, bool cold_boot);
 
 void sbi_ipi_exit(struct sbi_scratch *scratch);
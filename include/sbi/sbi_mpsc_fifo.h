@@ -0,0 +1,42 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Lock-free bounded multi-producer single-consumer FIFO.
+ *
+ * Each slot carries a sequence number. A producer reserves a slot by
+ * advancing enq_pos with compare-and-swap, fills it and then publishes
+ * it by storing the next sequence number with release ordering. The
+ * consumer owns deq_pos and never takes a lock.
+ */
+
+#ifndef __SBI_MPSC_FIFO_H__
+#define __SBI_MPSC_FIFO_H__
+
+#include <sbi/sbi_types.h>
+
+struct sbi_mpsc_fifo {
+	void *queue;
+	volatile unsigned long enq_pos;
+	unsigned long deq_pos;
+	u16 entry_size;
+	u16 slot_size;
+	u16 num_entries;
+};
+
+/** Size of one slot holding an entry of given size */
+#define SBI_MPSC_FIFO_SLOT_SIZE(__entry_size)			\
+	(sizeof(unsigned long) +				\
+	 (((__entry_size) + sizeof(unsigned long) - 1) &	\
+	  ~(sizeof(unsigned long) - 1)))
+
+/** Size of queue memory for given number of entries of given size */
+#define SBI_MPSC_FIFO_MEM_SIZE(__entries, __entry_size)	\
+	((__entries) * SBI_MPSC_FIFO_SLOT_SIZE(__entry_size))
+
+int sbi_mpsc_fifo_init(struct sbi_mpsc_fifo *fifo, void *queue_mem,
+		       u16 entries, u16 entry_size);
+int sbi_mpsc_fifo_enqueue(struct sbi_mpsc_fifo *fifo, void *data);
+int sbi_mpsc_fifo_dequeue(struct sbi_mpsc_fifo *fifo, void *data);
+bool sbi_mpsc_fifo_is_empty(struct sbi_mpsc_fifo *fifo);
+
+#endif
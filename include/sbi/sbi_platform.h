@@ -38,6 +38,11 @@
 
 #define SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_DEFAULT		(1UL << 12)
 
+/** Range flush limit asking for per-HART calibration at boot */
+#define SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_CALIBRATE		(~0ULL)
+
+#define SBI_PLATFORM_TLB_FIFO_NUM_ENTRIES_DEFAULT		8
+
 #ifndef __ASSEMBLY__
 
 #include <sbi/sbi_ecall.h>
@@ -114,15 +119,27 @@ struct sbi_platform_operations {
 
 	/** Send IPI to a target HART */
 	void (*ipi_send)(u32 target_hart);
+	/** Send IPI to all HARTs of a mask, starting from a base HART */
+	void (*ipi_send_mask)(ulong hmask, ulong hbase);
 	/** Clear IPI for a target HART */
 	void (*ipi_clear)(u32 target_hart);
+	/** Raise S-mode software interrupt of a target HART directly */
+	int (*ipi_smode_send)(u32 target_hart);
 	/** Initialize IPI for current HART */
 	int (*ipi_init)(bool cold_boot);
 	/** Exit IPI for current HART */
 	void (*ipi_exit)(void);
+	/** Sleep current HART until an event is signalled by another HART */
+	int (*wait_event)(void);
+	/** Signal an event to HARTs sleeping in wait_event */
+	void (*signal_event)(void);
 
 	/** Get tlb flush limit value **/
 	u64 (*get_tlbr_flush_limit)(void);
+	/** Get number of entries in per-HART tlb request fifo **/
+	u32 (*get_tlb_fifo_num_entries)(void);
+	/** Get lowest HART id of the cluster containing a HART **/
+	u32 (*get_hart_cluster)(u32 hartid);
 
 	/** Get platform timer value */
 	u64 (*timer_value)(void);
@@ -158,8 +175,11 @@ struct sbi_platform_operations {
 				   struct sbi_trap_info *out_trap);
 } __packed;
 
-/** Platform default per-HART stack size for exception/interrupt handling */
-#define SBI_PLATFORM_DEFAULT_HART_STACK_SIZE	8192
+/**
+ * Platform default per-HART stack size for exception/interrupt handling,
+ * including the scratch space at its top
+ */
+#define SBI_PLATFORM_DEFAULT_HART_STACK_SIZE	(0x1000 + SBI_SCRATCH_SIZE)
 
 /** Representation of a platform */
 struct sbi_platform {
@@ -286,7 +306,9 @@ static inline unsigned long sbi_platform_get_features(
  * @param plat pointer to struct sbi_platform
  *
  * @return tlb range flush limit value. Returns a default (page size) if not
- * defined by platform.
+ * defined by platform. Zero means every request is a full flush and
+ * SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_CALIBRATE means the limit is
+ * calibrated per type on every HART at boot.
  */
 static inline u64 sbi_platform_tlbr_flush_limit(const struct sbi_platform *plat)
 {
@@ -295,6 +317,41 @@ static inline u64 sbi_platform_tlbr_flush_limit(const struct sbi_platform *plat)
 	return SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_DEFAULT;
 }
 
+/**
+ * Get platform specific number of entries in per-HART tlb request fifo.
+ *
+ * @param plat pointer to struct sbi_platform
+ *
+ * @return number of tlb fifo entries. Returns a default value if not
+ * defined by platform.
+ */
+static inline u32 sbi_platform_tlb_fifo_num_entries(
+					const struct sbi_platform *plat)
+{
+	if (plat && sbi_platform_ops(plat)->get_tlb_fifo_num_entries)
+		return sbi_platform_ops(plat)->get_tlb_fifo_num_entries();
+	return SBI_PLATFORM_TLB_FIFO_NUM_ENTRIES_DEFAULT;
+}
+
+/**
+ * Get the cluster of a HART. A cluster is identified by the lowest HART
+ * id among its HARTs and remote fences to a cluster are relayed by one
+ * of its HARTs.
+ *
+ * @param plat pointer to struct sbi_platform
+ * @param hartid HART ID
+ *
+ * @return lowest HART id of the cluster. Returns the HART id itself if
+ * not defined by platform, in which case every HART is its own cluster.
+ */
+static inline u32 sbi_platform_hart_cluster(const struct sbi_platform *plat,
+					    u32 hartid)
+{
+	if (plat && sbi_platform_ops(plat)->get_hart_cluster)
+		return sbi_platform_ops(plat)->get_hart_cluster(hartid);
+	return hartid;
+}
+
 /**
  * Get total number of HARTs supported by the platform
  *
@@ -596,6 +653,53 @@ static inline void sbi_platform_ipi_send(const struct sbi_platform *plat,
 		sbi_platform_ops(plat)->ipi_send(target_hart);
 }
 
+/**
+ * Send IPI to all HARTs of a mask
+ *
+ * Uses the platform multicast operation when available, otherwise
+ * sends the IPIs one HART at a time.
+ *
+ * @param plat pointer to struct sbi_platform
+ * @param hmask mask of target HARTs relative to hbase
+ * @param hbase HART ID of bit 0 of hmask
+ */
+static inline void sbi_platform_ipi_send_mask(const struct sbi_platform *plat,
+					      ulong hmask, ulong hbase)
+{
+	ulong i;
+
+	if (!plat)
+		return;
+
+	if (sbi_platform_ops(plat)->ipi_send_mask) {
+		sbi_platform_ops(plat)->ipi_send_mask(hmask, hbase);
+		return;
+	}
+
+	for (i = hbase; hmask; i++, hmask >>= 1) {
+		if (hmask & 1UL)
+			sbi_platform_ipi_send(plat, i);
+	}
+}
+
+/**
+ * Raise S-mode software interrupt of a target HART without going through
+ * M-mode on the target HART
+ *
+ * @param plat pointer to struct sbi_platform
+ * @param target_hart HART ID of IPI target
+ *
+ * @return 0 on success and negative error code on failure. Returns
+ * SBI_ENOTSUPP if not supported by platform.
+ */
+static inline int sbi_platform_ipi_smode_send(const struct sbi_platform *plat,
+					      u32 target_hart)
+{
+	if (plat && sbi_platform_ops(plat)->ipi_smode_send)
+		return sbi_platform_ops(plat)->ipi_smode_send(target_hart);
+	return SBI_ENOTSUPP;
+}
+
 /**
  * Clear IPI for a target HART
  *
@@ -636,6 +740,32 @@ static inline void sbi_platform_ipi_exit(const struct sbi_platform *plat)
 		sbi_platform_ops(plat)->ipi_exit();
 }
 
+/**
+ * Sleep current HART until another HART signals an event or an enabled
+ * interrupt becomes pending
+ *
+ * @param plat pointer to struct sbi_platform
+ *
+ * @return TRUE if the HART slept and FALSE if not supported by platform
+ */
+static inline bool sbi_platform_wait_event(const struct sbi_platform *plat)
+{
+	if (plat && sbi_platform_ops(plat)->wait_event)
+		return sbi_platform_ops(plat)->wait_event() ? FALSE : TRUE;
+	return FALSE;
+}
+
+/**
+ * Signal an event to all HARTs sleeping in sbi_platform_wait_event()
+ *
+ * @param plat pointer to struct sbi_platform
+ */
+static inline void sbi_platform_signal_event(const struct sbi_platform *plat)
+{
+	if (plat && sbi_platform_ops(plat)->signal_event)
+		sbi_platform_ops(plat)->signal_event();
+}
+
 /**
  * Get platform timer value
  *
@@ -36,8 +36,18 @@
 #define SBI_SCRATCH_OPTIONS_OFFSET		(9 * __SIZEOF_POINTER__)
 /** Offset of extra space in sbi_scratch */
 #define SBI_SCRATCH_EXTRA_SPACE_OFFSET		(10 * __SIZEOF_POINTER__)
-/** Maximum size of sbi_scratch (4KB) */
+/**
+ * Maximum size of sbi_scratch (4KB for up to 128 HARTs)
+ *
+ * The TLB records of a HART hold hartmasks, so beyond 128 HARTs the
+ * space grows by eight hartmasks rounded up to 256 bytes.
+ */
+#if defined(SBI_HARTMASK_MAX_BITS) && (SBI_HARTMASK_MAX_BITS > 128)
+#define SBI_SCRATCH_SIZE			\
+	(0x1000 + (((SBI_HARTMASK_MAX_BITS - 128) + 255) & ~255))
+#else
 #define SBI_SCRATCH_SIZE			(0x1000)
+#endif
 
 /* clang-format on */
 
@@ -12,7 +12,6 @@
 #define __SBI_TLB_H__
 
 #include <sbi/sbi_types.h>
-#include <sbi/sbi_hartmask.h>
 
 /* clang-format off */
 
@@ -20,7 +19,15 @@
 
 /* clang-format on */
 
-#define SBI_TLB_FIFO_NUM_ENTRIES		8
+/*
+ * Bounds for the platform specific tlb fifo size. The size is rounded
+ * down to a power of two within these bounds.
+ */
+#define SBI_TLB_FIFO_NUM_ENTRIES_MIN		2
+#define SBI_TLB_FIFO_NUM_ENTRIES_MAX		64
+
+/* Maximum number of requests drained before flushing and completing them */
+#define SBI_TLB_MERGE_BATCH_MAX			8
 
 enum sbi_tlb_info_types {
 	SBI_TLB_FLUSH_VMA,
@@ -32,6 +39,53 @@ enum sbi_tlb_info_types {
 	SBI_ITLB_FLUSH
 };
 
+/** Rules used to coalesce queued requests on the remote HART */
+enum sbi_tlb_merge_rule {
+	/** Requests can not be merged */
+	SBI_TLB_MERGE_NONE = -1,
+	/** Overlapping or adjacent ranges of same address space */
+	SBI_TLB_MERGE_RANGE = 0,
+	/** One request lies within the other */
+	SBI_TLB_MERGE_CONTAIN,
+	/** Absorbed by a flush-all of the same scope */
+	SBI_TLB_MERGE_FLUSH_ALL,
+	/** Repeated fence.i requests */
+	SBI_TLB_MERGE_FENCE_I,
+	SBI_TLB_MERGE_MAX
+};
+
+/** Number of log2 buckets in tlb histograms */
+#define SBI_TLB_HIST_BUCKETS			20
+
+/**
+ * Per-HART remote fence statistics
+ *
+ * Histogram bucket 0 counts zero samples, bucket n counts samples in
+ * [2^(n-1), 2^n) and the last bucket also counts everything above.
+ */
+struct sbi_tlb_stats {
+	/** Requests issued by this HART per request type */
+	unsigned long request[SBI_ITLB_FLUSH + 1];
+	/** Requests merged on this HART per merge rule */
+	unsigned long merge[SBI_TLB_MERGE_MAX];
+	/** Requests of this HART which found the remote fifo full */
+	unsigned long fifo_full;
+	/** Ranged flushes on this HART upgraded to a full flush */
+	unsigned long upgrade;
+	/** Requests of this HART recorded for a non-running remote HART */
+	unsigned long deferred;
+	/** Cycles this HART waited for remote HARTs to complete */
+	unsigned long sync_hist[SBI_TLB_HIST_BUCKETS];
+	/** Cycles this HART spent flushing a batch of requests */
+	unsigned long flush_hist[SBI_TLB_HIST_BUCKETS];
+	/** Timer ticks from publishing a request until this HART took it */
+	unsigned long delivery_hist[SBI_TLB_HIST_BUCKETS];
+};
+
+/** Number of unsigned long words in struct sbi_tlb_stats */
+#define SBI_TLB_STATS_WORDS	\
+	(sizeof(struct sbi_tlb_stats) / sizeof(unsigned long))
+
 struct sbi_scratch;
 
 struct sbi_tlb_info {
@@ -40,7 +94,7 @@ struct sbi_tlb_info {
 	unsigned long asid;
 	unsigned long vmid;
 	unsigned long type;
-	struct sbi_hartmask smask;
+	u32 src;
 };
 
 #define SBI_TLB_INFO_INIT(__p, __start, __size, __asid, __vmid, __type, __src) \
@@ -50,13 +104,24 @@ do { \
 	(__p)->asid = (__asid); \
 	(__p)->vmid = (__vmid); \
 	(__p)->type = (__type); \
-	SBI_HARTMASK_INIT_EXCEPT(&(__p)->smask, (__src)); \
+	(__p)->src = (__src); \
 } while (0)
 
 #define SBI_TLB_INFO_SIZE		sizeof(struct sbi_tlb_info)
 
 int sbi_tlb_request(ulong hmask, ulong hbase, struct sbi_tlb_info *tinfo);
 
+void sbi_tlb_suspend(struct sbi_scratch *scratch);
+
+void sbi_tlb_resume(struct sbi_scratch *scratch);
+
+int sbi_tlb_stats_read(u32 hartid, unsigned long index,
+		       unsigned long *out_val);
+
+int sbi_tlb_stats_reset(u32 hartid);
+
+void sbi_tlb_stats_dump(struct sbi_scratch *scratch);
+
 int sbi_tlb_init(struct sbi_scratch *scratch, bool cold_boot);
 
 #endif
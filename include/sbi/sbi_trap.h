@@ -207,6 +207,8 @@ struct sbi_trap_info {
 int sbi_trap_redirect(struct sbi_trap_regs *regs,
 		      struct sbi_trap_info *trap);
 
+int sbi_trap_irq_handler(unsigned long mcause);
+
 void sbi_trap_handler(struct sbi_trap_regs *regs);
 
 #endif
@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Polite waiting for a condition set by another HART.
+ */
+
+#ifndef __SBI_WAIT_H__
+#define __SBI_WAIT_H__
+
+#include <sbi/sbi_types.h>
+
+/* Maximum number of pause hints issued by one backoff step */
+#define SBI_WAIT_BACKOFF_MAX		64
+
+/** State of one wait loop */
+struct sbi_wait {
+	/** Pause hints issued by the next backoff step */
+	unsigned long backoff;
+	/** The condition is always followed by sbi_wait_signal() */
+	bool event;
+};
+
+#define SBI_WAIT_INIT(__w, __event)	\
+do {					\
+	(__w)->backoff = 1;		\
+	(__w)->event = (__event);	\
+} while (0)
+
+/**
+ * Zihintpause hint. It is encoded as a FENCE with an empty successor
+ * set, which executes as a no-op on HARTs without Zihintpause.
+ */
+static inline void sbi_cpu_relax(void)
+{
+	__asm__ __volatile__(".4byte 0x0100000f" ::: "memory");
+}
+
+void sbi_wait_relax(struct sbi_wait *w);
+
+void sbi_wait_signal(void);
+
+/**
+ * Wait until a condition becomes true. If event is TRUE, every writer
+ * making the condition true must call sbi_wait_signal() afterwards.
+ */
+#define sbi_wait_until(__cond, __event)			\
+do {							\
+	struct sbi_wait __w;				\
+	SBI_WAIT_INIT(&__w, (__event));			\
+	while (!(__cond))				\
+		sbi_wait_relax(&__w);			\
+} while (0)
+
+#endif
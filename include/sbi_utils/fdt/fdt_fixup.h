@@ -34,6 +34,19 @@ void fdt_cpu_fixup(void *fdt);
  */
 void fdt_plic_fixup(void *fdt, const char *compat);
 
+/**
+ * Fix up the ACLINT nodes in the device tree
+ *
+ * This routine enables the ACLINT SSWI nodes so that S-mode software can
+ * raise supervisor software interrupts directly and disables the ACLINT
+ * MSWI nodes which are only accessible to M-mode.
+ *
+ * It is recommended that platform codes call this helper in their final_init()
+ *
+ * @param fdt: device tree blob
+ */
+void fdt_aclint_fixup(void *fdt);
+
 /**
  * Fix up the reserved memory node in the device tree
  *
@@ -32,6 +32,9 @@ int fdt_find_match(void *fdt, int startoff,
 		   const struct fdt_match *match_table,
 		   const struct fdt_match **out_match);
 
+int fdt_get_node_addr_size_by_index(void *fdt, int node, int index,
+				    unsigned long *addr, unsigned long *size);
+
 int fdt_get_node_addr_size(void *fdt, int node, unsigned long *addr,
 			   unsigned long *size);
 
@@ -39,6 +42,8 @@ int fdt_parse_hart_id(void *fdt, int cpu_offset, u32 *hartid);
 
 int fdt_parse_max_hart_id(void *fdt, u32 *max_hartid);
 
+int fdt_parse_hart_cluster(void *fdt, u32 hartid, u32 *cluster_hartid);
+
 int fdt_parse_sifive_uart_node(void *fdt, int nodeoffset,
 			       struct platform_uart_data *uart);
 
@@ -59,6 +64,10 @@ struct clint_data;
 int fdt_parse_clint_node(void *fdt, int nodeoffset, bool for_timer,
 			 struct clint_data *clint);
 
+int fdt_parse_aclint_node(void *fdt, int nodeoffset, u32 match_hwirq,
+			  unsigned long *out_addr, unsigned long *out_size,
+			  u32 *out_first_hartid, u32 *out_hart_count);
+
 int fdt_parse_compat_addr(void *fdt, unsigned long *addr,
 			  const char *compatible);
 
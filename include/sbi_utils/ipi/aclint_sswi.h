@@ -0,0 +1,28 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * RISC-V ACLINT supervisor-level software interrupt (SSWI) device.
+ */
+
+#ifndef __IPI_ACLINT_SSWI_H__
+#define __IPI_ACLINT_SSWI_H__
+
+#include <sbi/sbi_types.h>
+
+#define ACLINT_SSWI_ALIGN		0x1000
+#define ACLINT_SSWI_SIZE		0x4000
+#define ACLINT_SSWI_MAX_HARTS		(ACLINT_SSWI_SIZE / sizeof(u32))
+
+struct aclint_sswi_data {
+	/* Public details */
+	unsigned long addr;
+	unsigned long size;
+	u32 first_hartid;
+	u32 hart_count;
+};
+
+int aclint_sswi_send(u32 target_hart);
+
+int aclint_sswi_cold_init(struct aclint_sswi_data *sswi);
+
+#endif
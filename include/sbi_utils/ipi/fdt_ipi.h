@@ -18,11 +18,16 @@ struct fdt_ipi {
 	int (*warm_init)(void);
 	void (*exit)(void);
 	void (*send)(u32 target_hart);
+	void (*send_mask)(ulong hmask, ulong hbase);
 	void (*clear)(u32 target_hart);
 };
 
 void fdt_ipi_send(u32 target_hart);
 
+void fdt_ipi_send_mask(ulong hmask, ulong hbase);
+
+int fdt_ipi_smode_send(u32 target_hart);
+
 void fdt_ipi_clear(u32 target_hart);
 
 void fdt_ipi_exit(void);
@@ -31,6 +31,8 @@ struct clint_data {
 
 void clint_ipi_send(u32 target_hart);
 
+void clint_ipi_send_mask(ulong hmask, ulong hbase);
+
 void clint_ipi_clear(u32 target_hart);
 
 int clint_warm_ipi_init(void);
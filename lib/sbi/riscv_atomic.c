@@ -208,6 +208,18 @@ unsigned long atomic_raw_xchg_ulong(volatile unsigned long *ptr,
 #endif
 }
 
+unsigned long atomic_raw_cmpxchg_ulong(volatile unsigned long *ptr,
+				       unsigned long oldval,
+				       unsigned long newval)
+{
+	/* Atomically replace old value with new value and return old value. */
+#ifdef __riscv_atomic
+	return __sync_val_compare_and_swap(ptr, oldval, newval);
+#else
+	return cmpxchg(ptr, oldval, newval);
+#endif
+}
+
 #if (__SIZEOF_POINTER__ == 8)
 #define __AMO(op) "amo" #op ".d"
 #elif (__SIZEOF_POINTER__ == 4)
@@ -234,16 +246,31 @@ unsigned long atomic_raw_xchg_ulong(volatile unsigned long *ptr,
 #define __NOP(x) (x)
 #define __NOT(x) (~(x))
 
-inline int atomic_raw_set_bit(int nr, volatile unsigned long *addr)
+inline unsigned long atomic_raw_set_bit(int nr,
+					 volatile unsigned long *addr)
 {
 	return __atomic_op_bit(or, __NOP, nr, addr);
 }
 
-inline int atomic_raw_clear_bit(int nr, volatile unsigned long *addr)
+inline unsigned long atomic_raw_clear_bit(int nr,
+					 volatile unsigned long *addr)
 {
 	return __atomic_op_bit(and, __NOT, nr, addr);
 }
 
+unsigned long atomic_raw_fetch_or_ulong(unsigned long mask,
+					volatile unsigned long *addr)
+{
+	unsigned long res;
+
+	__asm__ __volatile__(__AMO(or) ".aqrl %0, %2, %1"
+			     : "=r"(res), "+A"(*addr)
+			     : "r"(mask)
+			     : "memory");
+
+	return res;
+}
+
 inline int atomic_set_bit(int nr, atomic_t *atom)
 {
 	return atomic_raw_set_bit(nr, (unsigned long *)&atom->counter);
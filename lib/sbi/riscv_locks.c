@@ -7,6 +7,7 @@
 
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_locks.h>
+#include <sbi/sbi_wait.h>
 
 static inline int spin_lock_unlocked(spinlock_t lock)
 {
@@ -48,30 +49,51 @@ int spin_trylock(spinlock_t *lock)
 void spin_lock(spinlock_t *lock)
 {
 	unsigned long inc = 1u << TICKET_SHIFT;
-	unsigned long mask = 0xffffu;
-	u32 l0, tmp1, tmp2;
+	struct sbi_wait w;
+	u32 l0;
+	u16 ticket;
 
+	/* Atomically increment the next ticket. */
 	__asm__ __volatile__(
-		/* Atomically increment the next ticket. */
-		"	amoadd.w.aqrl	%0, %4, %3\n"
+		"	amoadd.w.aqrl	%0, %2, %1\n"
+		: "=&r"(l0), "+A"(*lock)
+		: "r"(inc)
+		: "memory");
 
-		/* Did we get the lock? */
-		"	srli	%1, %0, %6\n"
-		"	and	%1, %1, %5\n"
-		"1:	and	%2, %0, %5\n"
-		"	beq	%1, %2, 2f\n"
+	/* Did we get the lock? */
+	ticket = l0 >> TICKET_SHIFT;
+	if ((u16)l0 == ticket)
+		return;
 
-		/* If not, then spin on the lock. */
-		"	lw	%0, %3\n"
-		RISCV_ACQUIRE_BARRIER
-		"	j	1b\n"
-		"2:"
-		: "=&r"(l0), "=&r"(tmp1), "=&r"(tmp2), "+A"(*lock)
-		: "r"(inc), "r"(mask), "I"(TICKET_SHIFT)
-		: "memory");
+	/* If not, then wait for our turn. */
+	SBI_WAIT_INIT(&w, TRUE);
+	while (__smp_load_acquire(&lock->owner) != ticket)
+		sbi_wait_relax(&w);
 }
 
 void spin_unlock(spinlock_t *lock)
 {
-	__smp_store_release(&lock->owner, lock->owner + 1);
+	unsigned long mask = 0xffffu << TICKET_SHIFT;
+	u32 l0, tmp1, tmp2;
+
+	/*
+	 * Hand the lock to the next ticket and take the next ticket in the
+	 * same atomic update. Waiters queued before the release are seen
+	 * without a separate load and the full fence it would need.
+	 */
+	__asm__ __volatile__(
+		"1:	lr.w	%0, %3\n"
+		"	addi	%1, %0, 1\n"
+		"	and	%2, %0, %4\n"
+		"	and	%1, %1, %5\n"
+		"	or	%1, %1, %2\n"
+		"	sc.w.rl	%2, %1, %3\n"
+		"	bnez	%2, 1b\n"
+		: "=&r"(l0), "=&r"(tmp1), "=&r"(tmp2), "+A"(*lock)
+		: "r"(mask), "r"(~mask)
+		: "memory");
+
+	/* Wake up waiters only when there are some */
+	if ((u16)(l0 >> TICKET_SHIFT) != (u16)(l0 + 1))
+		sbi_wait_signal();
 }
@@ -36,18 +36,65 @@ void sbi_ecall_set_impid(unsigned long impid)
 
 static SBI_LIST_HEAD(ecall_exts_list);
 
-struct sbi_ecall_extension *sbi_ecall_find_extension(unsigned long extid)
+/*
+ * Dispatch tables rebuilt from ecall_exts_list whenever an extension is
+ * registered or unregistered. The dense legacy extension IDs are looked
+ * up directly and all other IDs by binary search over extensions sorted
+ * by their first extension ID. Registered ranges never overlap so a
+ * range such as the vendor space is a single entry.
+ */
+#define ECALL_DIRECT_NUM		(SBI_EXT_0_1_SHUTDOWN + 1)
+
+static struct sbi_ecall_extension *ecall_direct[ECALL_DIRECT_NUM];
+static struct sbi_ecall_extension *ecall_sorted[SBI_ECALL_MAX_EXTENSIONS];
+static u32 ecall_sorted_count;
+
+static void sbi_ecall_rebuild(void)
 {
-	struct sbi_ecall_extension *t, *ret = NULL;
+	u32 i, j;
+	unsigned long extid;
+	struct sbi_ecall_extension *t;
+
+	for (i = 0; i < ECALL_DIRECT_NUM; i++)
+		ecall_direct[i] = NULL;
+	ecall_sorted_count = 0;
 
 	sbi_list_for_each_entry(t, &ecall_exts_list, head) {
-		if (t->extid_start <= extid && extid <= t->extid_end) {
-			ret = t;
-			break;
+		for (extid = t->extid_start;
+		     extid <= t->extid_end && extid < ECALL_DIRECT_NUM; extid++)
+			ecall_direct[extid] = t;
+
+		/* Insertion sort by first extension ID */
+		for (j = ecall_sorted_count; j > 0; j--) {
+			if (ecall_sorted[j - 1]->extid_start < t->extid_start)
+				break;
+			ecall_sorted[j] = ecall_sorted[j - 1];
 		}
+		ecall_sorted[j] = t;
+		ecall_sorted_count++;
 	}
+}
 
-	return ret;
+struct sbi_ecall_extension *sbi_ecall_find_extension(unsigned long extid)
+{
+	u32 lo = 0, hi = ecall_sorted_count, mid;
+	struct sbi_ecall_extension *t;
+
+	if (extid < ECALL_DIRECT_NUM)
+		return ecall_direct[extid];
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		t = ecall_sorted[mid];
+		if (extid < t->extid_start)
+			hi = mid;
+		else if (t->extid_end < extid)
+			lo = mid + 1;
+		else
+			return t;
+	}
+
+	return NULL;
 }
 
 int sbi_ecall_register_extension(struct sbi_ecall_extension *ext)
@@ -66,8 +113,12 @@ int sbi_ecall_register_extension(struct sbi_ecall_extension *ext)
 			return SBI_EINVAL;
 	}
 
+	if (SBI_ECALL_MAX_EXTENSIONS <= ecall_sorted_count)
+		return SBI_ENOSPC;
+
 	SBI_INIT_LIST_HEAD(&ext->head);
 	sbi_list_add_tail(&ext->head, &ecall_exts_list);
+	sbi_ecall_rebuild();
 
 	return 0;
 }
@@ -87,8 +138,10 @@ void sbi_ecall_unregister_extension(struct sbi_ecall_extension *ext)
 		}
 	}
 
-	if (found)
+	if (found) {
 		sbi_list_del_init(&ext->head);
+		sbi_ecall_rebuild();
+	}
 }
 
 int sbi_ecall_handler(struct sbi_trap_regs *regs)
@@ -145,7 +198,6 @@ int sbi_ecall_init(void)
 {
 	int ret;
 
-	/* The order of below registrations is performance optimized */
 	ret = sbi_ecall_register_extension(&ecall_time);
 	if (ret)
 		return ret;
@@ -167,6 +219,11 @@ int sbi_ecall_init(void)
 	ret = sbi_ecall_register_extension(&ecall_vendor);
 	if (ret)
 		return ret;
+#ifdef SBI_IPI_STATS
+	ret = sbi_ecall_register_extension(&ecall_stats);
+	if (ret)
+		return ret;
+#endif
 
 	return 0;
 }
@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * OpenSBI firmware extension exposing per-HART statistics to S-mode.
+ */
+
+#include <sbi/sbi_ecall.h>
+#include <sbi/sbi_ecall_interface.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_ipi.h>
+#include <sbi/sbi_tlb.h>
+
+static int sbi_ecall_stats_handler(unsigned long extid, unsigned long funcid,
+				   unsigned long *args, unsigned long *out_val,
+				   struct sbi_trap_info *out_trap)
+{
+	int ret = 0;
+
+	switch (funcid) {
+	case SBI_EXT_STATS_TLB_READ:
+	case SBI_EXT_STATS_TLB_RESET:
+	case SBI_EXT_STATS_IPI_READ:
+	case SBI_EXT_STATS_IPI_RESET:
+		/* Check the whole HART id before it is truncated to u32 */
+		if (SBI_HARTMASK_MAX_BITS <= args[0])
+			return SBI_EINVAL;
+		break;
+	default:
+		break;
+	};
+
+	switch (funcid) {
+	case SBI_EXT_STATS_TLB_NUM_WORDS:
+		*out_val = SBI_TLB_STATS_WORDS;
+		break;
+	case SBI_EXT_STATS_TLB_READ:
+		ret = sbi_tlb_stats_read(args[0], args[1], out_val);
+		break;
+	case SBI_EXT_STATS_TLB_RESET:
+		ret = sbi_tlb_stats_reset(args[0]);
+		break;
+	case SBI_EXT_STATS_IPI_NUM_WORDS:
+		*out_val = SBI_IPI_STATS_WORDS;
+		break;
+	case SBI_EXT_STATS_IPI_READ:
+		ret = sbi_ipi_stats_read(args[0], args[1], out_val);
+		break;
+	case SBI_EXT_STATS_IPI_RESET:
+		ret = sbi_ipi_stats_reset(args[0]);
+		break;
+	default:
+		ret = SBI_ENOTSUPP;
+	};
+
+	return ret;
+}
+
+struct sbi_ecall_extension ecall_stats = {
+	.extid_start = SBI_EXT_STATS,
+	.extid_end = SBI_EXT_STATS,
+	.handle = sbi_ecall_stats_handler,
+};
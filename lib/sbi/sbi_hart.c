@@ -284,6 +284,9 @@ static inline char *sbi_hart_feature_id2string(unsigned long feature)
 	case SBI_HART_HAS_TIME:
 		fstr = "time";
 		break;
+	case SBI_HART_HAS_SVINVAL:
+		fstr = "svinval";
+		break;
 	default:
 		break;
 	}
@@ -334,6 +337,24 @@ done:
 		sbi_strncpy(features_str, "none", nfstr);
 }
 
+/* Execute sfence.w.inval which traps as illegal without Svinval */
+static void hart_detect_svinval(struct sbi_trap_info *trap)
+{
+	register ulong tinfo asm("a3") = (ulong)trap;
+	register ulong ttmp asm("a4");
+	register ulong mtvec = sbi_hart_expected_trap_addr();
+
+	asm volatile(
+		"add %[ttmp], %[tinfo], zero\n"
+		"csrrw %[mtvec], " STR(CSR_MTVEC) ", %[mtvec]\n"
+		".word 0x18000073\n"
+		"csrw " STR(CSR_MTVEC) ", %[mtvec]"
+	    : [mtvec] "+&r"(mtvec), [tinfo] "+&r"(tinfo),
+	      [ttmp] "+&r"(ttmp)
+	    :
+	    : "memory");
+}
+
 static void hart_detect_features(struct sbi_scratch *scratch)
 {
 	struct sbi_trap_info trap = {0};
@@ -398,6 +419,12 @@ static void hart_detect_features(struct sbi_scratch *scratch)
 	csr_read_allowed(CSR_TIME, (unsigned long)&trap);
 	if (!trap.cause)
 		hfeatures->features |= SBI_HART_HAS_TIME;
+
+	/* Detect if hart supports Svinval extension */
+	trap.cause = 0;
+	hart_detect_svinval(&trap);
+	if (!trap.cause)
+		hfeatures->features |= SBI_HART_HAS_SVINVAL;
 }
 
 int sbi_hart_init(struct sbi_scratch *scratch, u32 hartid, bool cold_boot)
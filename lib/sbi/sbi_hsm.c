@@ -23,12 +23,21 @@
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_system.h>
 #include <sbi/sbi_timer.h>
+#include <sbi/sbi_tlb.h>
 #include <sbi/sbi_console.h>
 #include "../platform/andes/ae350/smu.h"
 #include "../platform/andes/ae350/platform.h"
 
 static unsigned long hart_data_offset;
 
+/*
+ * Mask of STARTED HARTs. A HART is added once its state becomes STARTED
+ * and before it applies deferred TLB maintenance, so a sender which
+ * misses it in the mask is covered by that maintenance. It is removed
+ * once its state leaves STARTED.
+ */
+static struct sbi_hartmask hsm_started_mask;
+
 /** Per hart specific data to manage state transition **/
 struct sbi_hsm_data {
 	atomic_t state;
@@ -89,19 +98,19 @@ bool sbi_hsm_hart_started(u32 hartid)
  */
 int sbi_hsm_hart_started_mask(ulong hbase, ulong *out_hmask)
 {
-	ulong i;
+	ulong word = BIT_WORD(hbase), shift = hbase % BITS_PER_LONG;
 	ulong hcount = sbi_scratch_last_hartid() + 1;
+	volatile unsigned long *bits = sbi_hartmask_bits(&hsm_started_mask);
 
 	*out_hmask = 0;
-	if (hcount <= hbase)
+	if (hcount <= hbase || SBI_HARTMASK_MAX_BITS <= hbase)
 		return SBI_EINVAL;
-	if (BITS_PER_LONG < (hcount - hbase))
-		hcount = BITS_PER_LONG;
 
-	for (i = hbase; i < hcount; i++) {
-		if (sbi_hsm_hart_get_state(i) == SBI_HART_STARTED)
-			*out_hmask |= 1UL << (i - hbase);
-	}
+	*out_hmask = bits[word] >> shift;
+	if (shift && (word + 1) < BITS_TO_LONGS(SBI_HARTMASK_MAX_BITS))
+		*out_hmask |= bits[word + 1] << (BITS_PER_LONG - shift);
+	if ((hcount - hbase) < BITS_PER_LONG)
+		*out_hmask &= (1UL << (hcount - hbase)) - 1;
 
 	return 0;
 }
@@ -116,6 +125,10 @@ void sbi_hsm_prepare_next_jump(struct sbi_scratch *scratch, u32 hartid)
 				  SBI_HART_STARTED);
 	if (oldstate != SBI_HART_STARTING)
 		sbi_hart_hang();
+	atomic_raw_set_bit(hartid, sbi_hartmask_bits(&hsm_started_mask));
+
+	/* Apply TLB maintenance recorded while we were not started */
+	sbi_tlb_resume(scratch);
 }
 
 static void sbi_hsm_hart_wait(struct sbi_scratch *scratch, u32 hartid)
@@ -162,6 +175,8 @@ int sbi_hsm_init(struct sbi_scratch *scratch, u32 hartid, bool cold_boot)
 		if (!hart_data_offset)
 			return SBI_ENOMEM;
 
+		SBI_HARTMASK_INIT(&hsm_started_mask);
+
 		/* Initialize hart state data for every hart */
 		for (i = 0; i <= sbi_scratch_last_hartid(); i++) {
 			rscratch = sbi_hartid_to_scratch(i);
@@ -288,6 +303,7 @@ int sbi_hsm_hart_stop(struct sbi_scratch *scratch, bool exitnow)
 			   __func__, oldstate);
 		return SBI_DENIED;
 	}
+	atomic_raw_clear_bit(hartid, sbi_hartmask_bits(&hsm_started_mask));
 
 	if (exitnow)
 		sbi_exit(scratch);
@@ -351,6 +351,9 @@ void __noreturn sbi_exit(struct sbi_scratch *scratch)
 
 	sbi_timer_exit(scratch);
 
+	sbi_tlb_stats_dump(scratch);
+	sbi_ipi_stats_dump(scratch);
+
 	sbi_ipi_exit(scratch);
 
 	sbi_platform_irqchip_exit(plat);
@@ -12,34 +12,157 @@
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
 #include <sbi/sbi_bitops.h>
+#include <sbi/sbi_console.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_hsm.h>
 #include <sbi/sbi_init.h>
 #include <sbi/sbi_ipi.h>
+#include <sbi/sbi_mpsc_fifo.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_string.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_wait.h>
 
+/*
+ * The stamp of an event holds the timer value of the oldest send which
+ * is not yet taken by the HART, or zero when there is none.
+ *
+ * A sender rings the doorbell of a remote HART only when it moves the
+ * remote ipi_type from zero, every other sender relies on it. Doorbells
+ * owed by this HART are kept in doorbell, relative to doorbell_base,
+ * until they are rung together. They must be rung before this HART
+ * waits for anything, otherwise the HARTs it waits for may never be
+ * interrupted.
+ */
 struct sbi_ipi_data {
 	unsigned long ipi_type;
+	unsigned long doorbell;
+	unsigned long doorbell_base;
+#ifdef SBI_IPI_STATS
+	unsigned long stamp[SBI_IPI_LAT_EVENTS];
+#endif
+};
+
+/*
+ * Remote function call issued by a HART. It lives in the scratch space
+ * of the caller and target HARTs only receive a pointer to it through
+ * their call fifo. The pending counter is decremented by every target
+ * after running the function so the caller waits once for all of them.
+ */
+struct sbi_ipi_call_desc {
+	sbi_ipi_call_fn fn;
+	void *arg;
+	bool wait;
+	atomic_t pending;
+	/** First error returned by fn on any target HART */
+	atomic_t ret;
 };
 
 static unsigned long ipi_data_off;
+static unsigned long ipi_call_desc_off;
+static unsigned long ipi_call_fifo_off;
+static unsigned long ipi_call_fifo_mem_off;
 
 static const struct sbi_ipi_event_ops *ipi_ops_array[SBI_IPI_EVENT_MAX];
 
-static int sbi_ipi_send(struct sbi_scratch *scratch, u32 remote_hartid,
-			u32 event, void *data)
+#ifdef SBI_IPI_STATS
+
+static unsigned long ipi_stats_off;
+
+static inline struct sbi_ipi_stats *sbi_ipi_stats_ptr(
+					struct sbi_scratch *scratch)
+{
+	return sbi_scratch_offset_ptr(scratch, ipi_stats_off);
+}
+
+/* Stamp must be visible before the type bit */
+static inline void sbi_ipi_stats_stamp(struct sbi_ipi_data *ipi_data,
+				       u32 event)
+{
+	if (event < SBI_IPI_LAT_EVENTS && !ipi_data->stamp[event])
+		atomic_raw_cmpxchg_ulong(&ipi_data->stamp[event], 0,
+					 (unsigned long)sbi_timer_value());
+}
+
+static inline void sbi_ipi_stats_doorbell(struct sbi_scratch *scratch,
+					  ulong rung, ulong skipped)
+{
+	struct sbi_ipi_stats *stats = sbi_ipi_stats_ptr(scratch);
+
+	stats->doorbell_sent += rung;
+	stats->doorbell_saved += skipped;
+}
+
+static void sbi_ipi_hist_add(unsigned long *hist, unsigned long val)
+{
+	unsigned long bucket = (val) ? __fls(val) + 1 : 0;
+
+	if (bucket >= SBI_IPI_HIST_BUCKETS)
+		bucket = SBI_IPI_HIST_BUCKETS - 1;
+	hist[bucket]++;
+}
+
+/* Run process callback of an event and record its latency */
+static void sbi_ipi_process_event(struct sbi_scratch *scratch,
+				  struct sbi_ipi_data *ipi_data, u32 event,
+				  const struct sbi_ipi_event_ops *ipi_ops)
+{
+	unsigned long stamp, cycles;
+	struct sbi_ipi_event_stats *ev;
+
+	if (SBI_IPI_LAT_EVENTS <= event) {
+		ipi_ops->process(scratch);
+		return;
+	}
+	ev = &sbi_ipi_stats_ptr(scratch)->event[event];
+
+	stamp = atomic_raw_xchg_ulong(&ipi_data->stamp[event], 0);
+	if (stamp)
+		sbi_ipi_hist_add(ev->delivery_hist,
+				 (unsigned long)sbi_timer_value() - stamp);
+
+	cycles = csr_read(CSR_MCYCLE);
+	ipi_ops->process(scratch);
+	sbi_ipi_hist_add(ev->handler_hist, csr_read(CSR_MCYCLE) - cycles);
+	ev->count++;
+}
+
+#else
+
+static inline void sbi_ipi_stats_stamp(struct sbi_ipi_data *ipi_data,
+				       u32 event)
+{
+}
+
+static inline void sbi_ipi_stats_doorbell(struct sbi_scratch *scratch,
+					  ulong rung, ulong skipped)
+{
+}
+
+static inline void sbi_ipi_process_event(struct sbi_scratch *scratch,
+				struct sbi_ipi_data *ipi_data, u32 event,
+				const struct sbi_ipi_event_ops *ipi_ops)
+{
+	ipi_ops->process(scratch);
+}
+
+#endif
+
+/*
+ * Call the update callback and set the IPI type on remote HART's scratch
+ * area. Returns zero when the remote HART has to be interrupted and one
+ * when it already had events pending, in which case its interrupt is
+ * still pending or it has not yet taken the events in sbi_ipi_process().
+ */
+static int sbi_ipi_update(struct sbi_scratch *scratch, u32 remote_hartid,
+			  u32 event, void *data)
 {
 	int ret;
 	struct sbi_scratch *remote_scratch = NULL;
-	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 	struct sbi_ipi_data *ipi_data;
-	const struct sbi_ipi_event_ops *ipi_ops;
-
-	if ((SBI_IPI_EVENT_MAX <= event) ||
-	    !ipi_ops_array[event])
-		return SBI_EINVAL;
-	ipi_ops = ipi_ops_array[event];
+	const struct sbi_ipi_event_ops *ipi_ops = ipi_ops_array[event];
 
 	remote_scratch = sbi_hartid_to_scratch(remote_hartid);
 	if (!remote_scratch)
@@ -54,31 +177,87 @@ static int sbi_ipi_send(struct sbi_scratch *scratch, u32 remote_hartid,
 			return ret;
 	}
 
-	/*
-	 * Set IPI type on remote hart's scratch area and
-	 * trigger the interrupt
-	 */
-	atomic_raw_set_bit(event, &ipi_data->ipi_type);
-	smp_wmb();
-	sbi_platform_ipi_send(plat, remote_hartid);
+	sbi_ipi_stats_stamp(ipi_data, event);
 
-	if (ipi_ops->sync)
-		ipi_ops->sync(scratch);
+	/* Set IPI type on remote hart's scratch area */
+	if (atomic_raw_fetch_or_ulong(BIT(event), &ipi_data->ipi_type))
+		return 1;
 
 	return 0;
 }
 
+/* Ring the doorbells owed by this HART */
+static void sbi_ipi_ring(struct sbi_scratch *scratch)
+{
+	struct sbi_ipi_data *ipi_data =
+			sbi_scratch_offset_ptr(scratch, ipi_data_off);
+
+	if (!ipi_data->doorbell)
+		return;
+
+	smp_wmb();
+	sbi_platform_ipi_send_mask(sbi_platform_ptr(scratch),
+				   ipi_data->doorbell,
+				   ipi_data->doorbell_base);
+	ipi_data->doorbell = 0;
+}
+
+/*
+ * Update all HARTs of the mask first and then trigger the interrupts
+ * together so that platforms with a multicast doorbell need a single
+ * write. An update callback which has to wait rings the doorbells owed
+ * so far through sbi_ipi_ring() first.
+ */
+static ulong sbi_ipi_send_mask(struct sbi_scratch *scratch,
+			       ulong m, ulong hbase, u32 event, void *data)
+{
+	int ret;
+	ulong i, sent = 0, rung = 0;
+	struct sbi_ipi_data *ipi_data =
+			sbi_scratch_offset_ptr(scratch, ipi_data_off);
+
+	/* Doorbells of an outer send when called from an update callback */
+	sbi_ipi_ring(scratch);
+	ipi_data->doorbell_base = hbase;
+
+	sbi_hmask_for_each_bit(i, m) {
+		ret = sbi_ipi_update(scratch, hbase + i, event, data);
+		if (ret < 0)
+			continue;
+		if (!ret) {
+			ipi_data->doorbell |= 1UL << i;
+			rung++;
+		}
+		sent++;
+	}
+	sbi_ipi_stats_doorbell(scratch, rung, sent - rung);
+
+	sbi_ipi_ring(scratch);
+
+	return sent;
+}
+
 /**
  * As this this function only handlers scalar values of hart mask, it must be
  * set to all online harts if the intention is to send IPIs to all the harts.
  * If hmask is zero, no IPIs will be sent.
+ *
+ * The update callback and the interrupt are issued for every target HART
+ * first and the sync callback is called only once afterwards so that the
+ * remote HARTs process the event in parallel.
  */
 int sbi_ipi_send_many(ulong hmask, ulong hbase, u32 event, void *data)
 {
 	int rc;
-	ulong i, m;
+	ulong m, sent = 0;
+	const struct sbi_ipi_event_ops *ipi_ops;
 	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
 
+	if ((SBI_IPI_EVENT_MAX <= event) ||
+	    !ipi_ops_array[event])
+		return SBI_EINVAL;
+	ipi_ops = ipi_ops_array[event];
+
 	if (hbase != -1UL) {
 		rc = sbi_hsm_hart_started_mask(hbase, &m);
 		if (rc)
@@ -86,22 +265,21 @@ int sbi_ipi_send_many(ulong hmask, ulong hbase, u32 event, void *data)
 		m &= hmask;
 
 		/* Send IPIs */
-		for (i = hbase; m; i++, m >>= 1) {
-			if (m & 1UL)
-				sbi_ipi_send(scratch, i, event, data);
-		}
+		sent += sbi_ipi_send_mask(scratch, m, hbase, event, data);
 	} else {
 		hbase = 0;
 		while (!sbi_hsm_hart_started_mask(hbase, &m)) {
 			/* Send IPIs */
-			for (i = hbase; m; i++, m >>= 1) {
-				if (m & 1UL)
-					sbi_ipi_send(scratch, i, event, data);
-			}
+			sent += sbi_ipi_send_mask(scratch, m, hbase,
+						  event, data);
 			hbase += BITS_PER_LONG;
 		}
 	}
 
+	/* Wait once for all remote HARTs */
+	if (sent && ipi_ops->sync)
+		ipi_ops->sync(scratch);
+
 	return 0;
 }
 
@@ -143,9 +321,52 @@ static struct sbi_ipi_event_ops ipi_smode_ops = {
 
 static u32 ipi_smode_event = SBI_IPI_EVENT_MAX;
 
+/*
+ * Raise S-mode software interrupt directly where the platform can do it
+ * and return the mask of HARTs which still need an M-mode IPI.
+ */
+static ulong sbi_ipi_smode_direct(const struct sbi_platform *plat,
+				  ulong m, ulong hbase)
+{
+	ulong i, rest = 0;
+
+	sbi_hmask_for_each_bit(i, m) {
+		if (sbi_platform_ipi_smode_send(plat, hbase + i))
+			rest |= 1UL << i;
+	}
+
+	return rest;
+}
+
 int sbi_ipi_send_smode(ulong hmask, ulong hbase)
 {
-	return sbi_ipi_send_many(hmask, hbase, ipi_smode_event, NULL);
+	int rc;
+	ulong m;
+	const struct sbi_platform *plat = sbi_platform_thishart_ptr();
+
+	if (!sbi_platform_ops(plat)->ipi_smode_send)
+		return sbi_ipi_send_many(hmask, hbase, ipi_smode_event, NULL);
+
+	if (hbase != -1UL) {
+		rc = sbi_hsm_hart_started_mask(hbase, &m);
+		if (rc)
+			return rc;
+		m = sbi_ipi_smode_direct(plat, m & hmask, hbase);
+		if (m)
+			return sbi_ipi_send_many(m, hbase,
+						 ipi_smode_event, NULL);
+	} else {
+		hbase = 0;
+		while (!sbi_hsm_hart_started_mask(hbase, &m)) {
+			m = sbi_ipi_smode_direct(plat, m, hbase);
+			if (m)
+				sbi_ipi_send_many(m, hbase,
+						  ipi_smode_event, NULL);
+			hbase += BITS_PER_LONG;
+		}
+	}
+
+	return 0;
 }
 
 void sbi_ipi_clear_smode(void)
@@ -170,28 +391,22 @@ int sbi_ipi_send_halt(ulong hmask, ulong hbase)
 	return sbi_ipi_send_many(hmask, hbase, ipi_halt_event, NULL);
 }
 
-void sbi_ipi_process(void)
+/* Run the process callbacks of the events set in ipi_type */
+static void sbi_ipi_process_type(struct sbi_scratch *scratch,
+				 struct sbi_ipi_data *ipi_data,
+				 unsigned long ipi_type)
 {
-	unsigned long ipi_type;
-	unsigned int ipi_event;
+	unsigned int ipi_event = 0;
 	const struct sbi_ipi_event_ops *ipi_ops;
-	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
-	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
-	struct sbi_ipi_data *ipi_data =
-			sbi_scratch_offset_ptr(scratch, ipi_data_off);
 
-	u32 hartid = current_hartid();
-	sbi_platform_ipi_clear(plat, hartid);
-
-	ipi_type = atomic_raw_xchg_ulong(&ipi_data->ipi_type, 0);
-	ipi_event = 0;
 	while (ipi_type) {
 		if (!(ipi_type & 1UL))
 			goto skip;
 
 		ipi_ops = ipi_ops_array[ipi_event];
 		if (ipi_ops && ipi_ops->process)
-			ipi_ops->process(scratch);
+			sbi_ipi_process_event(scratch, ipi_data,
+					      ipi_event, ipi_ops);
 
 skip:
 		ipi_type = ipi_type >> 1;
@@ -199,16 +414,312 @@ skip:
 	};
 }
 
+/*
+ * Handle the events of this HART while it waits for remote HARTs with
+ * interrupts disabled. Unlike sbi_ipi_process() the doorbell is not
+ * cleared and IPI_HALT is left set, so both are taken by the next
+ * sbi_ipi_process() once the wait is over.
+ */
+static void sbi_ipi_process_waiting(struct sbi_scratch *scratch)
+{
+	unsigned long ipi_type;
+	struct sbi_ipi_data *ipi_data =
+			sbi_scratch_offset_ptr(scratch, ipi_data_off);
+
+	if (!(ipi_data->ipi_type & ~BIT(ipi_halt_event)))
+		return;
+
+	ipi_type = atomic_raw_xchg_ulong(&ipi_data->ipi_type, 0);
+	if (ipi_type & BIT(ipi_halt_event)) {
+		atomic_raw_set_bit(ipi_halt_event, &ipi_data->ipi_type);
+		ipi_type &= ~BIT(ipi_halt_event);
+	}
+
+	sbi_ipi_process_type(scratch, ipi_data, ipi_type);
+}
+
+static void sbi_ipi_call_wait(struct sbi_scratch *scratch,
+			      struct sbi_ipi_call_desc *desc)
+{
+	struct sbi_wait w;
+
+	/*
+	 * Targets may themselves be waiting on this HART for another
+	 * event while interrupts are disabled in M-mode so keep handling
+	 * our own events to avoid deadlock.
+	 */
+	SBI_WAIT_INIT(&w, TRUE);
+	while (atomic_read(&desc->pending)) {
+		sbi_ipi_process_waiting(scratch);
+		sbi_wait_relax(&w);
+	}
+}
+
+/* Run the function of a call and keep its first error */
+static void sbi_ipi_call_run(struct sbi_ipi_call_desc *desc)
+{
+	int rc = desc->fn(desc->arg);
+
+	if (rc)
+		atomic_cmpxchg(&desc->ret, 0, rc);
+}
+
+static void sbi_ipi_call_process(struct sbi_scratch *scratch)
+{
+	struct sbi_ipi_call_desc *desc;
+	struct sbi_mpsc_fifo *call_fifo =
+			sbi_scratch_offset_ptr(scratch, ipi_call_fifo_off);
+
+	while (!sbi_mpsc_fifo_dequeue(call_fifo, &desc)) {
+		sbi_ipi_call_run(desc);
+		if (!atomic_sub_return(&desc->pending, 1))
+			sbi_wait_signal();
+	}
+}
+
+static int sbi_ipi_call_update(struct sbi_scratch *scratch,
+			       struct sbi_scratch *remote_scratch,
+			       u32 remote_hartid, void *data)
+{
+	struct sbi_ipi_call_desc *desc = data;
+	struct sbi_mpsc_fifo *call_fifo_r;
+	struct sbi_wait w;
+
+	/* Run the function directly when the caller is a target */
+	if (remote_hartid == current_hartid()) {
+		sbi_ipi_call_run(desc);
+		return -1;
+	}
+
+	call_fifo_r = sbi_scratch_offset_ptr(remote_scratch,
+					     ipi_call_fifo_off);
+
+	atomic_add_return(&desc->pending, 1);
+	if (!sbi_mpsc_fifo_enqueue(call_fifo_r, &desc))
+		return 0;
+
+	/* Targets updated so far may be the ones holding up the remote */
+	sbi_ipi_ring(scratch);
+
+	SBI_WAIT_INIT(&w, FALSE);
+	while (sbi_mpsc_fifo_enqueue(call_fifo_r, &desc) < 0) {
+		/*
+		 * Remote fifo is full so handle our own events while
+		 * waiting for space to avoid deadlock.
+		 */
+		sbi_ipi_process_waiting(scratch);
+		sbi_wait_relax(&w);
+	}
+
+	return 0;
+}
+
+static void sbi_ipi_call_sync(struct sbi_scratch *scratch)
+{
+	struct sbi_ipi_call_desc *desc =
+			sbi_scratch_offset_ptr(scratch, ipi_call_desc_off);
+
+	if (desc->wait)
+		sbi_ipi_call_wait(scratch, desc);
+}
+
+static struct sbi_ipi_event_ops ipi_call_ops = {
+	.name = "IPI_CALL",
+	.update = sbi_ipi_call_update,
+	.sync = sbi_ipi_call_sync,
+	.process = sbi_ipi_call_process,
+};
+
+static u32 ipi_call_event = SBI_IPI_EVENT_MAX;
+
+/**
+ * Run a function on the HARTs of the mask which are started. The calling
+ * HART runs it directly if it is part of the mask and the others run it
+ * from their IPI handler. The function must not call sbi_ipi_call_many().
+ *
+ * When wait is true the first error returned by the function on any
+ * HART is returned. When wait is false the call returns as soon as all
+ * targets are signalled, arg must stay valid until they are done and
+ * errors of the function are lost. The next call from the same HART
+ * waits for the previous one to complete.
+ */
+int sbi_ipi_call_many(ulong hmask, ulong hbase,
+		      sbi_ipi_call_fn fn, void *arg, bool wait)
+{
+	int rc;
+	struct sbi_ipi_call_desc *desc;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+
+	if (!fn)
+		return SBI_EINVAL;
+
+	desc = sbi_scratch_offset_ptr(scratch, ipi_call_desc_off);
+
+	/* Previous call may still be in flight */
+	sbi_ipi_call_wait(scratch, desc);
+
+	desc->fn = fn;
+	desc->arg = arg;
+	desc->wait = wait;
+	atomic_write(&desc->ret, 0);
+
+	rc = sbi_ipi_send_many(hmask, hbase, ipi_call_event, desc);
+	if (rc || !wait)
+		return rc;
+
+	return atomic_read(&desc->ret);
+}
+
+void sbi_ipi_process(void)
+{
+	unsigned long ipi_type;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
+	struct sbi_ipi_data *ipi_data =
+			sbi_scratch_offset_ptr(scratch, ipi_data_off);
+
+	u32 hartid = current_hartid();
+	sbi_platform_ipi_clear(plat, hartid);
+
+	/*
+	 * Senders ring the doorbell only when ipi_type goes from zero to
+	 * non-zero so the clear must complete before ipi_type is taken.
+	 * Otherwise a doorbell rung right after the exchange could be lost.
+	 */
+	mb();
+
+	ipi_type = atomic_raw_xchg_ulong(&ipi_data->ipi_type, 0);
+	sbi_ipi_process_type(scratch, ipi_data, ipi_type);
+}
+
+#ifdef SBI_IPI_STATS
+
+static struct sbi_scratch *sbi_ipi_stats_scratch(u32 hartid)
+{
+	/* HART id comes from S-mode so check it before the table lookup */
+	if (SBI_HARTMASK_MAX_BITS <= hartid ||
+	    sbi_scratch_last_hartid() < hartid)
+		return NULL;
+
+	return sbi_hartid_to_scratch(hartid);
+}
+
+int sbi_ipi_stats_read(u32 hartid, unsigned long index,
+		       unsigned long *out_val)
+{
+	struct sbi_scratch *rscratch = sbi_ipi_stats_scratch(hartid);
+
+	if (!rscratch || !ipi_stats_off || SBI_IPI_STATS_WORDS <= index)
+		return SBI_EINVAL;
+
+	*out_val = ((unsigned long *)sbi_scratch_offset_ptr(rscratch,
+						ipi_stats_off))[index];
+
+	return 0;
+}
+
+int sbi_ipi_stats_reset(u32 hartid)
+{
+	struct sbi_scratch *rscratch = sbi_ipi_stats_scratch(hartid);
+
+	if (!rscratch || !ipi_stats_off)
+		return SBI_EINVAL;
+
+	sbi_memset(sbi_scratch_offset_ptr(rscratch, ipi_stats_off), 0,
+		   sizeof(struct sbi_ipi_stats));
+
+	return 0;
+}
+
+static void sbi_ipi_hist_dump(u32 hartid, const char *event,
+			      const char *name, unsigned long *hist)
+{
+	int i;
+
+	sbi_dprintf("hart%d: ipi %s %s:", hartid, event, name);
+	for (i = 0; i < SBI_IPI_HIST_BUCKETS; i++)
+		sbi_dprintf(" %lu", hist[i]);
+	sbi_dprintf("\n");
+}
+
+void sbi_ipi_stats_dump(struct sbi_scratch *scratch)
+{
+	u32 i, hartid = current_hartid();
+	struct sbi_ipi_stats *stats;
+	struct sbi_ipi_event_stats *ev;
+
+	if (!ipi_stats_off)
+		return;
+	stats = sbi_scratch_offset_ptr(scratch, ipi_stats_off);
+
+	sbi_dprintf("hart%d: ipi doorbell_sent=%lu doorbell_saved=%lu\n",
+		    hartid, stats->doorbell_sent, stats->doorbell_saved);
+
+	for (i = 0; i < SBI_IPI_LAT_EVENTS; i++) {
+		ev = &stats->event[i];
+		if (!ipi_ops_array[i] || !ev->count)
+			continue;
+		sbi_dprintf("hart%d: ipi %s count=%lu\n", hartid,
+			    ipi_ops_array[i]->name, ev->count);
+		sbi_ipi_hist_dump(hartid, ipi_ops_array[i]->name,
+				  "delivery ticks", ev->delivery_hist);
+		sbi_ipi_hist_dump(hartid, ipi_ops_array[i]->name,
+				  "handler cycles", ev->handler_hist);
+	}
+}
+
+#else
+
+int sbi_ipi_stats_read(u32 hartid, unsigned long index,
+		       unsigned long *out_val)
+{
+	return SBI_ENOTSUPP;
+}
+
+int sbi_ipi_stats_reset(u32 hartid)
+{
+	return SBI_ENOTSUPP;
+}
+
+void sbi_ipi_stats_dump(struct sbi_scratch *scratch)
+{
+}
+
+#endif
+
 int sbi_ipi_init(struct sbi_scratch *scratch, bool cold_boot)
 {
 	int ret;
 	struct sbi_ipi_data *ipi_data;
+	struct sbi_ipi_call_desc *call_desc;
+	struct sbi_mpsc_fifo *call_fifo;
+	void *call_mem;
 
 	if (cold_boot) {
 		ipi_data_off = sbi_scratch_alloc_offset(sizeof(*ipi_data),
 							"IPI_DATA");
 		if (!ipi_data_off)
 			return SBI_ENOMEM;
+		ipi_call_desc_off = sbi_scratch_alloc_offset(
+				sizeof(*call_desc), "IPI_CALL_DESC");
+		if (!ipi_call_desc_off)
+			goto fail_free_data;
+		ipi_call_fifo_off = sbi_scratch_alloc_offset(
+				sizeof(*call_fifo), "IPI_CALL_FIFO");
+		if (!ipi_call_fifo_off)
+			goto fail_free_call_desc;
+		ipi_call_fifo_mem_off = sbi_scratch_alloc_offset(
+				SBI_MPSC_FIFO_MEM_SIZE(SBI_IPI_CALL_FIFO_NUM_ENTRIES,
+						       sizeof(call_desc)),
+				"IPI_CALL_FIFO_MEM");
+		if (!ipi_call_fifo_mem_off)
+			goto fail_free_call_fifo;
+#ifdef SBI_IPI_STATS
+		ipi_stats_off = sbi_scratch_alloc_offset(
+				sizeof(struct sbi_ipi_stats), "IPI_STATS");
+		if (!ipi_stats_off)
+			goto fail_free_call_fifo_mem;
+#endif
 		ret = sbi_ipi_event_create(&ipi_smode_ops);
 		if (ret < 0)
 			return ret;
@@ -217,16 +728,44 @@ int sbi_ipi_init(struct sbi_scratch *scratch, bool cold_boot)
 		if (ret < 0)
 			return ret;
 		ipi_halt_event = ret;
+		ret = sbi_ipi_event_create(&ipi_call_ops);
+		if (ret < 0)
+			return ret;
+		ipi_call_event = ret;
 	} else {
-		if (!ipi_data_off)
+		if (!ipi_data_off || !ipi_call_desc_off ||
+		    !ipi_call_fifo_off || !ipi_call_fifo_mem_off)
+			return SBI_ENOMEM;
+#ifdef SBI_IPI_STATS
+		if (!ipi_stats_off)
 			return SBI_ENOMEM;
+#endif
 		if (SBI_IPI_EVENT_MAX <= ipi_smode_event ||
-		    SBI_IPI_EVENT_MAX <= ipi_halt_event)
+		    SBI_IPI_EVENT_MAX <= ipi_halt_event ||
+		    SBI_IPI_EVENT_MAX <= ipi_call_event)
 			return SBI_ENOSPC;
 	}
 
 	ipi_data = sbi_scratch_offset_ptr(scratch, ipi_data_off);
 	ipi_data->ipi_type = 0x00;
+	ipi_data->doorbell = 0;
+#ifdef SBI_IPI_STATS
+	sbi_memset(ipi_data->stamp, 0, sizeof(ipi_data->stamp));
+#endif
+
+	call_desc = sbi_scratch_offset_ptr(scratch, ipi_call_desc_off);
+	call_desc->fn = NULL;
+	call_desc->arg = NULL;
+	call_desc->wait = FALSE;
+	ATOMIC_INIT(&call_desc->pending, 0);
+	ATOMIC_INIT(&call_desc->ret, 0);
+	call_fifo = sbi_scratch_offset_ptr(scratch, ipi_call_fifo_off);
+	call_mem = sbi_scratch_offset_ptr(scratch, ipi_call_fifo_mem_off);
+	ret = sbi_mpsc_fifo_init(call_fifo, call_mem,
+				 SBI_IPI_CALL_FIFO_NUM_ENTRIES,
+				 sizeof(call_desc));
+	if (ret)
+		return ret;
 
 	/* Platform init */
 	ret = sbi_platform_ipi_init(sbi_platform_ptr(scratch), cold_boot);
@@ -237,6 +776,18 @@ int sbi_ipi_init(struct sbi_scratch *scratch, bool cold_boot)
 	csr_set(CSR_MIE, MIP_MSIP);
 
 	return 0;
+
+#ifdef SBI_IPI_STATS
+fail_free_call_fifo_mem:
+	sbi_scratch_free_offset(ipi_call_fifo_mem_off);
+#endif
+fail_free_call_fifo:
+	sbi_scratch_free_offset(ipi_call_fifo_off);
+fail_free_call_desc:
+	sbi_scratch_free_offset(ipi_call_desc_off);
+fail_free_data:
+	sbi_scratch_free_offset(ipi_data_off);
+	return SBI_ENOMEM;
 }
 
 void sbi_ipi_exit(struct sbi_scratch *scratch)
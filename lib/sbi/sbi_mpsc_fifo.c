@@ -0,0 +1,127 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Lock-free bounded multi-producer single-consumer FIFO.
+ */
+
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_mpsc_fifo.h>
+
+struct sbi_mpsc_fifo_slot {
+	volatile unsigned long seq;
+	unsigned long data[];
+};
+
+static inline struct sbi_mpsc_fifo_slot *
+__sbi_mpsc_fifo_slot(struct sbi_mpsc_fifo *fifo, unsigned long pos)
+{
+	unsigned long idx = pos & (fifo->num_entries - 1);
+
+	return (struct sbi_mpsc_fifo_slot *)
+		((char *)fifo->queue + idx * fifo->slot_size);
+}
+
+static inline void __sbi_mpsc_fifo_copy(unsigned long *dst,
+					const unsigned long *src,
+					unsigned long size)
+{
+	unsigned long i;
+
+	for (i = 0; i < size / sizeof(unsigned long); i++)
+		dst[i] = src[i];
+}
+
+int sbi_mpsc_fifo_init(struct sbi_mpsc_fifo *fifo, void *queue_mem,
+		       u16 entries, u16 entry_size)
+{
+	unsigned long i;
+	struct sbi_mpsc_fifo_slot *slot;
+
+	if (!fifo || !queue_mem || !entries || (entries & (entries - 1)))
+		return SBI_EINVAL;
+	if (!entry_size || (entry_size & (sizeof(unsigned long) - 1)))
+		return SBI_EINVAL;
+
+	fifo->queue	  = queue_mem;
+	fifo->num_entries = entries;
+	fifo->entry_size  = entry_size;
+	fifo->slot_size   = SBI_MPSC_FIFO_SLOT_SIZE(entry_size);
+	fifo->enq_pos	  = 0;
+	fifo->deq_pos	  = 0;
+
+	for (i = 0; i < entries; i++) {
+		slot = __sbi_mpsc_fifo_slot(fifo, i);
+		slot->seq = i;
+	}
+	smp_wmb();
+
+	return 0;
+}
+
+int sbi_mpsc_fifo_enqueue(struct sbi_mpsc_fifo *fifo, void *data)
+{
+	long diff;
+	unsigned long pos, seq;
+	struct sbi_mpsc_fifo_slot *slot;
+
+	if (!fifo || !data)
+		return SBI_EINVAL;
+
+	pos = fifo->enq_pos;
+	while (1) {
+		slot = __sbi_mpsc_fifo_slot(fifo, pos);
+		seq = __smp_load_acquire(&slot->seq);
+		diff = (long)(seq - pos);
+		if (!diff) {
+			/* Slot is free, try to reserve it */
+			if (atomic_raw_cmpxchg_ulong(&fifo->enq_pos,
+						     pos, pos + 1) == pos)
+				break;
+		} else if (diff < 0) {
+			/* Consumer has not released this slot yet */
+			return SBI_ENOSPC;
+		}
+		pos = fifo->enq_pos;
+	}
+
+	__sbi_mpsc_fifo_copy(slot->data, data, fifo->entry_size);
+	__smp_store_release(&slot->seq, pos + 1);
+
+	return 0;
+}
+
+int sbi_mpsc_fifo_dequeue(struct sbi_mpsc_fifo *fifo, void *data)
+{
+	unsigned long pos, seq;
+	struct sbi_mpsc_fifo_slot *slot;
+
+	if (!fifo || !data)
+		return SBI_EINVAL;
+
+	pos = fifo->deq_pos;
+	slot = __sbi_mpsc_fifo_slot(fifo, pos);
+	seq = __smp_load_acquire(&slot->seq);
+	if ((long)(seq - (pos + 1)) < 0)
+		return SBI_ENOENT;
+
+	__sbi_mpsc_fifo_copy(data, slot->data, fifo->entry_size);
+	fifo->deq_pos = pos + 1;
+	__smp_store_release(&slot->seq, pos + fifo->num_entries);
+
+	return 0;
+}
+
+bool sbi_mpsc_fifo_is_empty(struct sbi_mpsc_fifo *fifo)
+{
+	unsigned long pos, seq;
+
+	if (!fifo)
+		return TRUE;
+
+	pos = fifo->deq_pos;
+	seq = __smp_load_acquire(&__sbi_mpsc_fifo_slot(fifo, pos)->seq);
+
+	return ((long)(seq - (pos + 1)) < 0) ? TRUE : FALSE;
+}
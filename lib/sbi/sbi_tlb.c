@@ -11,47 +11,292 @@
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
+#include <sbi/sbi_bitops.h>
 #include <sbi/sbi_error.h>
-#include <sbi/sbi_fifo.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_hsm.h>
 #include <sbi/sbi_ipi.h>
+#include <sbi/sbi_mpsc_fifo.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi/sbi_timer.h>
 #include <sbi/sbi_tlb.h>
 #include <sbi/sbi_hfence.h>
 #include <sbi/sbi_string.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_wait.h>
 
-static unsigned long tlb_sync_off;
+/*
+ * Shootdown descriptor published by the source HART in its own scratch
+ * space. Remote HARTs only receive a pointer to it through their fifo and
+ * decrement the pending count once the flush is done. The targets and
+ * relayed mask are only used when HARTs are grouped in clusters. Targets
+ * are kept as the scalar hart mask and base of the request so that their
+ * size does not depend on the maximum number of HARTs.
+ */
+struct sbi_tlb_desc {
+	struct sbi_tlb_info tinfo;
+	atomic_t pending;
+#ifdef SBI_IPI_STATS
+	u64 stamp;
+#endif
+	u32 hartid;
+	bool relay;
+	ulong target_mask;
+	ulong target_base;
+	struct sbi_hartmask relayed;
+};
+
+/*
+ * Cluster record of a HART. A request aimed at HARTs of another cluster
+ * is queued only on the first of them, tagged as a relay entry. That HART
+ * forwards the request to the targets of its cluster above itself using
+ * its own relay descriptor and completes the source descriptor once all
+ * of them are done, so the source only waits for one HART per cluster.
+ * If the fifo of the first target is full, the request is recorded in
+ * its overflow record instead and the next target becomes the relay.
+ */
+struct sbi_tlb_cluster {
+	/** Lowest HART id of the cluster */
+	u32 id;
+	/** HARTs of the cluster, valid only on the HART with the cluster id */
+	struct sbi_hartmask members;
+	/** Descriptor used to forward a relayed request */
+	struct sbi_tlb_desc relay;
+	/** Source descriptor of the request being relayed */
+	struct sbi_tlb_desc *relay_src;
+};
+
+#define TLB_ENTRY_RELAY			1UL
+
+/*
+ * Overflow record of a HART. When the tlb fifo of a HART is full, the
+ * source HART does not wait for space. Instead it sets the bit of its
+ * translation scope and its own bit in the source mask. The remote HART
+ * then flushes everything for the recorded scopes and completes all
+ * recorded sources. Requests forwarded by a relay HART are recorded
+ * in the relay mask and complete the relay descriptor instead. For the
+ * VS-stage, the VMID is kept in the upper bits of the scope word as
+ * VMID + 1. A VS-stage request for another VMID widens the record to
+ * the G-stage scope, whose flush covers the guests of all VMIDs.
+ */
+struct sbi_tlb_overflow {
+	volatile unsigned long scope;
+	struct sbi_hartmask srcs;
+	struct sbi_hartmask relays;
+};
+
+#define TLB_OVERFLOW_VMID_SHIFT		8
+
+/*
+ * Deferred maintenance record of a HART. Requests aimed at a HART which
+ * is not running are recorded here instead of sending an IPI and applied
+ * before the HART returns to S-mode. The ACTIVE bit is set by a running
+ * HART which is about to be suspended.
+ */
+#define TLB_DEFER_FLUSH_ALL		BIT(0)
+#define TLB_DEFER_FENCE_I		BIT(1)
+#define TLB_DEFER_ACTIVE		BIT(2)
+
+static unsigned long tlb_desc_off;
 static unsigned long tlb_fifo_off;
 static unsigned long tlb_fifo_mem_off;
-static unsigned long tlb_range_flush_limit;
+static unsigned long tlb_overflow_off;
+static unsigned long tlb_deferred_off;
+static unsigned long tlb_limit_off;
+static unsigned long tlb_cluster_off;
+static u16 tlb_fifo_num_entries;
+static bool tlb_clustered;
+
+/*
+ * Per-HART range flush limits in bytes. Above these limits a full flush
+ * of the address space is cheaper than per-page invalidation. They are
+ * calibrated once on every HART unless the platform provides a limit.
+ */
+struct sbi_tlb_limit {
+	unsigned long vma;
+	unsigned long gvma;
+	unsigned long vvma;
+	bool calibrated;
+};
+
+#define TLB_CALIBRATE_PAGES		16
+#define TLB_CALIBRATE_ROUNDS		4
+
+/*
+ * Worst-case scratch footprint of the TLB records of a HART, with the
+ * largest fifo and the statistics. The scratch header, the IPI records
+ * and the other users of the scratch space fit in the remaining
+ * TLB_SCRATCH_RESERVED bytes.
+ */
+#define TLB_SCRATCH_RESERVED		2048
+#define TLB_SCRATCH_FOOTPRINT					\
+	(sizeof(struct sbi_tlb_desc) +				\
+	 sizeof(struct sbi_mpsc_fifo) +				\
+	 SBI_MPSC_FIFO_MEM_SIZE(SBI_TLB_FIFO_NUM_ENTRIES_MAX,	\
+				sizeof(struct sbi_tlb_desc *)) +	\
+	 sizeof(struct sbi_tlb_overflow) +			\
+	 sizeof(unsigned long) +				\
+	 sizeof(struct sbi_tlb_limit) +				\
+	 sizeof(struct sbi_tlb_cluster) +			\
+	 sizeof(struct sbi_tlb_stats))
+
+_Static_assert(TLB_SCRATCH_FOOTPRINT + TLB_SCRATCH_RESERVED <=
+	       SBI_SCRATCH_SIZE,
+	       "TLB records do not fit in the scratch space");
+
+static inline struct sbi_tlb_cluster *sbi_tlb_cluster_ptr(
+					struct sbi_scratch *scratch)
+{
+	return sbi_scratch_offset_ptr(scratch, tlb_cluster_off);
+}
+
+#ifdef SBI_IPI_STATS
+
+static unsigned long tlb_stats_off;
+
+static inline struct sbi_tlb_stats *sbi_tlb_stats_ptr(
+					struct sbi_scratch *scratch)
+{
+	return sbi_scratch_offset_ptr(scratch, tlb_stats_off);
+}
+
+static void sbi_tlb_hist_add(unsigned long *hist, unsigned long val)
+{
+	unsigned long bucket = (val) ? __fls(val) + 1 : 0;
+
+	if (bucket >= SBI_TLB_HIST_BUCKETS)
+		bucket = SBI_TLB_HIST_BUCKETS - 1;
+	hist[bucket]++;
+}
+
+#define sbi_tlb_stats_inc(__scratch, __field)			\
+	(sbi_tlb_stats_ptr(__scratch)->__field++)
+
+#define sbi_tlb_stats_cycles()		csr_read(CSR_MCYCLE)
+
+#define sbi_tlb_stats_hist_cycles(__scratch, __field, __start)	\
+	sbi_tlb_hist_add(sbi_tlb_stats_ptr(__scratch)->__field,	\
+			 csr_read(CSR_MCYCLE) - (__start))
+
+static inline void sbi_tlb_stats_stamp(struct sbi_tlb_desc *desc)
+{
+	desc->stamp = sbi_timer_value();
+}
+
+/* The timer is read once per drained batch and shared by its entries */
+static inline void sbi_tlb_stats_delivery(struct sbi_scratch *scratch,
+					  struct sbi_tlb_desc *desc,
+					  u64 *now)
+{
+	if (!*now)
+		*now = sbi_timer_value();
+	sbi_tlb_hist_add(sbi_tlb_stats_ptr(scratch)->delivery_hist,
+			 *now - desc->stamp);
+}
+
+#else
+
+#define sbi_tlb_stats_inc(__scratch, __field)			\
+	do { } while (0)
+
+#define sbi_tlb_stats_cycles()		0
+
+#define sbi_tlb_stats_hist_cycles(__scratch, __field, __start)	\
+	do { (void)(__start); } while (0)
+
+static inline void sbi_tlb_stats_stamp(struct sbi_tlb_desc *desc)
+{
+}
+
+static inline void sbi_tlb_stats_delivery(struct sbi_scratch *scratch,
+					  struct sbi_tlb_desc *desc,
+					  u64 *now)
+{
+}
+
+#endif
+
+static inline void sbi_tlb_desc_done(struct sbi_tlb_desc *desc)
+{
+	if (!atomic_sub_return(&desc->pending, 1))
+		sbi_wait_signal();
+}
+
+/*
+ * With Svinval, the ordering cost is paid once per range using
+ * sfence.w.inval and sfence.inval.ir around per-page invalidations.
+ * A single page needs only one ordered fence without Svinval, so it
+ * keeps using the plain fence.
+ */
+static inline bool sbi_tlb_use_svinval(unsigned long size)
+{
+	return PAGE_SIZE < size &&
+	       sbi_hart_has_feature(sbi_scratch_thishart_ptr(),
+				    SBI_HART_HAS_SVINVAL);
+}
+
+static unsigned long sbi_tlb_range_limit(unsigned long type)
+{
+	struct sbi_tlb_limit *limit =
+		sbi_scratch_offset_ptr(sbi_scratch_thishart_ptr(),
+				       tlb_limit_off);
+
+	switch (type) {
+	case SBI_TLB_FLUSH_GVMA:
+	case SBI_TLB_FLUSH_GVMA_VMID:
+		return limit->gvma;
+	case SBI_TLB_FLUSH_VVMA:
+	case SBI_TLB_FLUSH_VVMA_ASID:
+		return limit->vvma;
+	default:
+		return limit->vma;
+	}
+}
 
 static void sbi_tlb_flush_all(void)
 {
 	__asm__ __volatile("sfence.vma");
 }
 
-static void sbi_tlb_hfence_vvma(struct sbi_tlb_info *tinfo)
+static inline unsigned long sbi_tlb_hgatp_vmid(unsigned long vmid)
+{
+	return (vmid << HGATP_VMID_SHIFT) & HGATP_VMID_MASK;
+}
+
+/* Note: HGATP must already hold the VMID of the request */
+static void __sbi_tlb_hfence_vvma(struct sbi_tlb_info *tinfo)
 {
 	unsigned long start = tinfo->start;
 	unsigned long size  = tinfo->size;
-	unsigned long vmid  = tinfo->vmid;
-	unsigned long i, hgatp;
-
-	hgatp = csr_swap(CSR_HGATP,
-			 (vmid << HGATP_VMID_SHIFT) & HGATP_VMID_MASK);
+	unsigned long i;
 
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL) ||
+	    (size > sbi_tlb_range_limit(tinfo->type))) {
 		__sbi_hfence_vvma_all();
-		goto done;
+		return;
+	}
+
+	if (sbi_tlb_use_svinval(size)) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_hinval_vvma_va(start + i);
+		__sbi_sfence_inval_ir();
+		return;
 	}
 
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__sbi_hfence_vvma_va(start+i);
 	}
+}
 
-done:
+static void sbi_tlb_hfence_vvma(struct sbi_tlb_info *tinfo)
+{
+	unsigned long hgatp;
+
+	hgatp = csr_swap(CSR_HGATP, sbi_tlb_hgatp_vmid(tinfo->vmid));
+	__sbi_tlb_hfence_vvma(tinfo);
 	csr_write(CSR_HGATP, hgatp);
 }
 
@@ -61,11 +306,20 @@ static void sbi_tlb_hfence_gvma(struct sbi_tlb_info *tinfo)
 	unsigned long size  = tinfo->size;
 	unsigned long i;
 
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL) ||
+	    (size > sbi_tlb_range_limit(tinfo->type))) {
 		__sbi_hfence_gvma_all();
 		return;
 	}
 
+	if (sbi_tlb_use_svinval(size)) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_hinval_gvma_gpa(start + i);
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__sbi_hfence_gvma_gpa(start+i);
 	}
@@ -77,11 +331,20 @@ static void sbi_tlb_sfence_vma(struct sbi_tlb_info *tinfo)
 	unsigned long size  = tinfo->size;
 	unsigned long i;
 
-	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL) ||
+	    (size > sbi_tlb_range_limit(tinfo->type))) {
 		sbi_tlb_flush_all();
 		return;
 	}
 
+	if (sbi_tlb_use_svinval(size)) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_sinval_vma_va(start + i);
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__asm__ __volatile__("sfence.vma %0"
 				     :
@@ -90,32 +353,44 @@ static void sbi_tlb_sfence_vma(struct sbi_tlb_info *tinfo)
 	}
 }
 
-static void sbi_tlb_hfence_vvma_asid(struct sbi_tlb_info *tinfo)
+/* Note: HGATP must already hold the VMID of the request */
+static void __sbi_tlb_hfence_vvma_asid(struct sbi_tlb_info *tinfo)
 {
 	unsigned long start = tinfo->start;
 	unsigned long size  = tinfo->size;
 	unsigned long asid  = tinfo->asid;
-	unsigned long vmid  = tinfo->vmid;
-	unsigned long i, hgatp;
-
-	hgatp = csr_swap(CSR_HGATP,
-			 (vmid << HGATP_VMID_SHIFT) & HGATP_VMID_MASK);
+	unsigned long i;
 
 	if (start == 0 && size == 0) {
 		__sbi_hfence_vvma_all();
-		goto done;
+		return;
 	}
 
-	if (size == SBI_TLB_FLUSH_ALL) {
+	if ((size == SBI_TLB_FLUSH_ALL) ||
+	    (size > sbi_tlb_range_limit(tinfo->type))) {
 		__sbi_hfence_vvma_asid(asid);
-		goto done;
+		return;
+	}
+
+	if (sbi_tlb_use_svinval(size)) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_hinval_vvma_asid_va(asid, start + i);
+		__sbi_sfence_inval_ir();
+		return;
 	}
 
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__sbi_hfence_vvma_asid_va(asid, start + i);
 	}
+}
 
-done:
+static void sbi_tlb_hfence_vvma_asid(struct sbi_tlb_info *tinfo)
+{
+	unsigned long hgatp;
+
+	hgatp = csr_swap(CSR_HGATP, sbi_tlb_hgatp_vmid(tinfo->vmid));
+	__sbi_tlb_hfence_vvma_asid(tinfo);
 	csr_write(CSR_HGATP, hgatp);
 }
 
@@ -131,11 +406,20 @@ static void sbi_tlb_hfence_gvma_vmid(struct sbi_tlb_info *tinfo)
 		return;
 	}
 
-	if (size == SBI_TLB_FLUSH_ALL) {
+	if ((size == SBI_TLB_FLUSH_ALL) ||
+	    (size > sbi_tlb_range_limit(tinfo->type))) {
 		__sbi_hfence_gvma_vmid(vmid);
 		return;
 	}
 
+	if (sbi_tlb_use_svinval(size)) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_hinval_gvma_vmid_gpa(vmid, start + i);
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__sbi_hfence_gvma_vmid_gpa(vmid, start+i);
 	}
@@ -154,7 +438,8 @@ static void sbi_tlb_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 	}
 
 	/* Flush entire MM context for a given ASID */
-	if (size == SBI_TLB_FLUSH_ALL) {
+	if ((size == SBI_TLB_FLUSH_ALL) ||
+	    (size > sbi_tlb_range_limit(tinfo->type))) {
 		__asm__ __volatile__("sfence.vma x0, %0"
 				     :
 				     : "r"(asid)
@@ -162,6 +447,14 @@ static void sbi_tlb_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 		return;
 	}
 
+	if (sbi_tlb_use_svinval(size)) {
+		__sbi_sfence_w_inval();
+		for (i = 0; i < size; i += PAGE_SIZE)
+			__sbi_sinval_vma_asid_va(asid, start + i);
+		__sbi_sfence_inval_ir();
+		return;
+	}
+
 	for (i = 0; i < size; i += PAGE_SIZE) {
 		__asm__ __volatile__("sfence.vma %0, %1"
 				     :
@@ -170,8 +463,23 @@ static void sbi_tlb_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 	}
 }
 
+static void sbi_tlb_count_upgrade(struct sbi_tlb_info *tinfo)
+{
+#ifdef SBI_IPI_STATS
+	if (tinfo->type == SBI_ITLB_FLUSH ||
+	    (tinfo->start == 0 && tinfo->size == 0) ||
+	    tinfo->size == SBI_TLB_FLUSH_ALL)
+		return;
+
+	if (tinfo->size > sbi_tlb_range_limit(tinfo->type))
+		sbi_tlb_stats_inc(sbi_scratch_thishart_ptr(), upgrade);
+#endif
+}
+
 static void sbi_tlb_local_flush(struct sbi_tlb_info *tinfo)
 {
+	sbi_tlb_count_upgrade(tinfo);
+
 	switch (tinfo->type) {
 	case SBI_TLB_FLUSH_VMA:
 		sbi_tlb_sfence_vma(tinfo);
@@ -201,185 +509,631 @@ static void sbi_tlb_local_flush(struct sbi_tlb_info *tinfo)
 	return;
 }
 
-static void sbi_tlb_entry_process(struct sbi_tlb_info *tinfo)
+static void sbi_tlb_entry_process(struct sbi_tlb_desc *desc)
 {
-	u32 rhartid;
-	struct sbi_scratch *rscratch = NULL;
-	unsigned long *rtlb_sync = NULL;
+	sbi_tlb_local_flush(&desc->tinfo);
+	sbi_tlb_desc_done(desc);
+}
 
-	sbi_tlb_local_flush(tinfo);
+/* Translation scope flushed by a request type */
+static inline unsigned long sbi_tlb_scope(struct sbi_tlb_info *tinfo)
+{
+	switch (tinfo->type) {
+	case SBI_TLB_FLUSH_VMA:
+	case SBI_TLB_FLUSH_VMA_ASID:
+		return SBI_TLB_FLUSH_VMA;
+	case SBI_TLB_FLUSH_GVMA:
+	case SBI_TLB_FLUSH_GVMA_VMID:
+		return SBI_TLB_FLUSH_GVMA;
+	case SBI_TLB_FLUSH_VVMA:
+	case SBI_TLB_FLUSH_VVMA_ASID:
+		return SBI_TLB_FLUSH_VVMA;
+	default:
+		return tinfo->type;
+	}
+}
 
-	sbi_hartmask_for_each_hart(rhartid, &tinfo->smask) {
-		rscratch = sbi_hartid_to_scratch(rhartid);
-		if (!rscratch)
-			continue;
+static inline bool sbi_tlb_is_global(struct sbi_tlb_info *tinfo)
+{
+	return (tinfo->start == 0 && tinfo->size == 0) ? TRUE : FALSE;
+}
 
-		rtlb_sync = sbi_scratch_offset_ptr(rscratch, tlb_sync_off);
-		while (atomic_raw_xchg_ulong(rtlb_sync, 1)) ;
+static inline bool sbi_tlb_range_all(struct sbi_tlb_info *tinfo)
+{
+	return (sbi_tlb_is_global(tinfo) ||
+		tinfo->size == SBI_TLB_FLUSH_ALL) ? TRUE : FALSE;
+}
+
+/*
+ * Returns TRUE if request is not limited to one address space. This is
+ * the case for untagged types and for the global (start == 0, size == 0)
+ * form of tagged types. The tag is the ASID for VMA_ASID and VVMA_ASID
+ * and the VMID for GVMA_VMID.
+ */
+static inline bool sbi_tlb_tag_all(struct sbi_tlb_info *tinfo)
+{
+	switch (tinfo->type) {
+	case SBI_TLB_FLUSH_VMA_ASID:
+	case SBI_TLB_FLUSH_GVMA_VMID:
+	case SBI_TLB_FLUSH_VVMA_ASID:
+		return sbi_tlb_is_global(tinfo);
+	default:
+		return TRUE;
 	}
 }
 
-static void sbi_tlb_process_count(struct sbi_scratch *scratch, int count)
+static inline unsigned long sbi_tlb_tag(struct sbi_tlb_info *tinfo)
 {
+	return (tinfo->type == SBI_TLB_FLUSH_GVMA_VMID) ?
+		tinfo->vmid : tinfo->asid;
+}
+
+/* Check whether flushing curr also flushes everything next asks for */
+static bool sbi_tlb_covers(struct sbi_tlb_info *curr,
+			   struct sbi_tlb_info *next)
+{
+	if (!sbi_tlb_tag_all(curr) &&
+	    (sbi_tlb_tag_all(next) || sbi_tlb_tag(curr) != sbi_tlb_tag(next)))
+		return FALSE;
+
+	if (sbi_tlb_range_all(curr))
+		return TRUE;
+	if (sbi_tlb_range_all(next))
+		return FALSE;
+
+	return (next->start >= curr->start &&
+		next->start + next->size <= curr->start + curr->size) ?
+		TRUE : FALSE;
+}
+
+/**
+ * Try to fold next dequeued request into current one. Requests are only
+ * merged within the same translation scope and, for the VS-stage, the
+ * same VMID. Here are the different cases that are being handled.
+ *
+ * Case1:
+ *	if current request is a flush-all for the scope, or next request
+ *	lies within current request, the next request is dropped.
+ * Case2:
+ *	if next request is a flush-all for the scope, or current request
+ *	lies within next request, the current request is replaced.
+ * Case3:
+ *	if both requests target the same address space and their ranges
+ *	overlap or are adjacent, the current request takes the union. The
+ *	union is upgraded to a flush of the whole address space when it
+ *	exceeds the range flush limit.
+ * Case4:
+ *	any number of fence.i requests collapse into one.
+ *
+ * In all cases the descriptor of next request is completed together
+ * with the current one once the flush is done. Merging is done by the
+ * consumer while draining so that producers only need to reserve a slot
+ * and never look at other entries.
+ */
+static int sbi_tlb_merge(struct sbi_tlb_info *curr,
+			 struct sbi_tlb_info *next)
+{
+	unsigned long start, end;
+
+	if (sbi_tlb_scope(curr) != sbi_tlb_scope(next))
+		return SBI_TLB_MERGE_NONE;
+
+	if (curr->type == SBI_ITLB_FLUSH)
+		return SBI_TLB_MERGE_FENCE_I;
+
+	if (sbi_tlb_scope(curr) == SBI_TLB_FLUSH_VVMA &&
+	    curr->vmid != next->vmid)
+		return SBI_TLB_MERGE_NONE;
+
+	if (sbi_tlb_covers(curr, next))
+		return (sbi_tlb_range_all(curr)) ?
+			SBI_TLB_MERGE_FLUSH_ALL : SBI_TLB_MERGE_CONTAIN;
+
+	if (sbi_tlb_covers(next, curr)) {
+		sbi_memcpy(curr, next, sizeof(*curr));
+		return (sbi_tlb_range_all(next)) ?
+			SBI_TLB_MERGE_FLUSH_ALL : SBI_TLB_MERGE_CONTAIN;
+	}
+
+	if (curr->type != next->type ||
+	    sbi_tlb_range_all(curr) || sbi_tlb_range_all(next) ||
+	    (!sbi_tlb_tag_all(curr) && sbi_tlb_tag(curr) != sbi_tlb_tag(next)))
+		return SBI_TLB_MERGE_NONE;
+
+	if (next->start > curr->start + curr->size ||
+	    curr->start > next->start + next->size)
+		return SBI_TLB_MERGE_NONE;
+
+	start = (curr->start < next->start) ? curr->start : next->start;
+	end = curr->start + curr->size;
+	if (end < next->start + next->size)
+		end = next->start + next->size;
+
+	curr->start = start;
+	curr->size = end - start;
+	if (curr->size > sbi_tlb_range_limit(curr->type)) {
+		curr->start = 0;
+		curr->size = SBI_TLB_FLUSH_ALL;
+	}
+
+	return SBI_TLB_MERGE_RANGE;
+}
+
+static void sbi_tlb_overflow_process(struct sbi_scratch *scratch)
+{
+	u32 i, rhartid;
+	unsigned long scope;
 	struct sbi_tlb_info tinfo;
-	u32 deq_count = 0;
-	struct sbi_fifo *tlb_fifo =
+	struct sbi_hartmask srcs, relays;
+	struct sbi_scratch *rscratch;
+	struct sbi_tlb_overflow *ovf =
+			sbi_scratch_offset_ptr(scratch, tlb_overflow_off);
+	unsigned long *bits = sbi_hartmask_bits(&ovf->srcs);
+	unsigned long *srcs_bits = sbi_hartmask_bits(&srcs);
+	unsigned long *relay_bits = sbi_hartmask_bits(&ovf->relays);
+	unsigned long *relays_bits = sbi_hartmask_bits(&relays);
+
+	/*
+	 * Sources are collected before the scope word. A source sets its
+	 * scope before its own bit so every collected source is covered
+	 * either by this flush or by an earlier one.
+	 */
+	for (i = 0; i < BITS_TO_LONGS(SBI_HARTMASK_MAX_BITS); i++) {
+		srcs_bits[i] = atomic_raw_xchg_ulong(&bits[i], 0);
+		relays_bits[i] = atomic_raw_xchg_ulong(&relay_bits[i], 0);
+	}
+	scope = atomic_raw_xchg_ulong(&ovf->scope, 0);
+
+	if (scope & BIT(SBI_TLB_FLUSH_VMA))
+		sbi_tlb_flush_all();
+	if (scope & BIT(SBI_TLB_FLUSH_GVMA))
+		__sbi_hfence_gvma_all();
+	if (scope & BIT(SBI_TLB_FLUSH_VVMA)) {
+		SBI_TLB_INFO_INIT(&tinfo, 0, SBI_TLB_FLUSH_ALL, 0,
+				  (scope >> TLB_OVERFLOW_VMID_SHIFT) - 1,
+				  SBI_TLB_FLUSH_VVMA, current_hartid());
+		sbi_tlb_hfence_vvma(&tinfo);
+	}
+	if (scope & BIT(SBI_ITLB_FLUSH))
+		__asm__ __volatile("fence.i");
+
+	sbi_hartmask_for_each_hart(rhartid, &srcs) {
+		rscratch = sbi_hartid_to_scratch(rhartid);
+		if (rscratch)
+			sbi_tlb_desc_done(sbi_scratch_offset_ptr(rscratch,
+								 tlb_desc_off));
+	}
+	sbi_hartmask_for_each_hart(rhartid, &relays) {
+		rscratch = sbi_hartid_to_scratch(rhartid);
+		if (rscratch)
+			sbi_tlb_desc_done(&sbi_tlb_cluster_ptr(rscratch)->relay);
+	}
+}
+
+/* Record an overflow on remote HART */
+static void sbi_tlb_overflow(struct sbi_scratch *remote_scratch,
+			     struct sbi_tlb_desc *desc)
+{
+	struct sbi_tlb_info *tinfo = &desc->tinfo;
+	unsigned long scope = sbi_tlb_scope(tinfo);
+	unsigned long old, new, vmid = 0;
+	struct sbi_tlb_overflow *ovf =
+			sbi_scratch_offset_ptr(remote_scratch, tlb_overflow_off);
+
+	if (scope == SBI_TLB_FLUSH_VVMA)
+		vmid = (tinfo->vmid + 1) << TLB_OVERFLOW_VMID_SHIFT;
+
+	do {
+		old = ovf->scope;
+		new = old;
+		/*
+		 * HFENCE.GVMA for all VMIDs also drops the VS-stage
+		 * translations of every guest, hypervisors rely on this
+		 * when VMIDs roll over.
+		 */
+		if (vmid && (old >> TLB_OVERFLOW_VMID_SHIFT) &&
+		    (old & ~(BIT(TLB_OVERFLOW_VMID_SHIFT) - 1)) != vmid)
+			new |= BIT(SBI_TLB_FLUSH_GVMA);
+		else
+			new |= BIT(scope) | vmid;
+	} while (atomic_raw_cmpxchg_ulong(&ovf->scope, old, new) != old);
+
+	atomic_raw_set_bit(desc->hartid, (desc->relay) ?
+			   sbi_hartmask_bits(&ovf->relays) :
+			   sbi_hartmask_bits(&ovf->srcs));
+}
+
+static int sbi_tlb_dequeue(struct sbi_scratch *scratch,
+			   struct sbi_tlb_desc **desc, bool *relay, u64 *now)
+{
+	unsigned long entry;
+	struct sbi_mpsc_fifo *tlb_fifo =
 			sbi_scratch_offset_ptr(scratch, tlb_fifo_off);
+	int ret = sbi_mpsc_fifo_dequeue(tlb_fifo, &entry);
+
+	if (ret)
+		return ret;
+
+	*relay = (entry & TLB_ENTRY_RELAY) ? TRUE : FALSE;
+	*desc = (struct sbi_tlb_desc *)(entry & ~TLB_ENTRY_RELAY);
+	sbi_tlb_stats_delivery(scratch, *desc, now);
+
+	return 0;
+}
+
+static u32 tlb_relay_event = SBI_IPI_EVENT_MAX;
+
+/* Targets of a request falling in given word of a hartmask */
+static unsigned long sbi_tlb_target_word(struct sbi_tlb_desc *desc, u32 i)
+{
+	ulong shift, word;
+
+	if (desc->target_base == -1UL)
+		return -1UL;
+
+	word = BIT_WORD(desc->target_base);
+	shift = desc->target_base % BITS_PER_LONG;
+	if (i == word)
+		return desc->target_mask << shift;
+	if (i == word + 1 && shift)
+		return desc->target_mask >> (BITS_PER_LONG - shift);
+
+	return 0;
+}
+
+/*
+ * Forward a relayed request to the targets of our cluster above us, the
+ * source already reached the ones below. If our relay descriptor is
+ * free, it collects their completion and TRUE is returned so that the
+ * caller completes the source descriptor through sbi_tlb_relay_finish().
+ * Otherwise the request is forwarded as is and the targets complete the
+ * source descriptor themselves.
+ */
+static bool sbi_tlb_relay_start(struct sbi_scratch *scratch,
+				struct sbi_tlb_desc *src)
+{
+	u32 i, hartid = current_hartid();
+	unsigned long m;
+	struct sbi_tlb_desc *fwd;
+	struct sbi_tlb_cluster *cl = sbi_tlb_cluster_ptr(scratch);
+	struct sbi_tlb_cluster *ccl =
+		sbi_tlb_cluster_ptr(sbi_hartid_to_scratch(cl->id));
+	unsigned long *members = sbi_hartmask_bits(&ccl->members);
+
+	if (!cl->relay_src) {
+		fwd = &cl->relay;
+		sbi_memcpy(&fwd->tinfo, &src->tinfo, sizeof(fwd->tinfo));
+#ifdef SBI_IPI_STATS
+		fwd->stamp = src->stamp;
+#endif
+		atomic_write(&fwd->pending, 0);
+		cl->relay_src = src;
+	} else {
+		fwd = src;
+	}
+
+	for (i = BIT_WORD(hartid); i < BITS_TO_LONGS(SBI_HARTMASK_MAX_BITS);
+	     i++) {
+		m = members[i] & sbi_tlb_target_word(src, i);
+		if (i == BIT_WORD(hartid))
+			m &= ~((BIT_MASK(hartid) << 1) - 1);
+		if (m)
+			sbi_ipi_send_many(m, i * BITS_PER_LONG,
+					  tlb_relay_event, fwd);
+	}
+
+	return (fwd == src) ? FALSE : TRUE;
+}
+
+static void sbi_tlb_relay_finish(struct sbi_scratch *scratch);
+
+/* Returns the number of requests taken from the fifo */
+static u32 sbi_tlb_process_count(struct sbi_scratch *scratch, u32 count)
+{
+	bool relay;
+	struct sbi_tlb_desc *desc;
+	u32 deq_count = 0;
+	u64 now = 0;
+
+	sbi_tlb_overflow_process(scratch);
 
-	while (!sbi_fifo_dequeue(tlb_fifo, &tinfo)) {
-		sbi_tlb_entry_process(&tinfo);
+	while (!sbi_tlb_dequeue(scratch, &desc, &relay, &now)) {
+		if (relay && sbi_tlb_relay_start(scratch, desc)) {
+			sbi_tlb_local_flush(&desc->tinfo);
+			sbi_tlb_relay_finish(scratch);
+		} else {
+			sbi_tlb_entry_process(desc);
+		}
 		deq_count++;
 		if (deq_count > count)
 			break;
 
 	}
+
+	return deq_count;
 }
 
-static void sbi_tlb_process(struct sbi_scratch *scratch)
+static inline int sbi_tlb_defer_bit(struct sbi_tlb_info *tinfo)
 {
-	struct sbi_tlb_info tinfo;
-	struct sbi_fifo *tlb_fifo =
-			sbi_scratch_offset_ptr(scratch, tlb_fifo_off);
+	return (tinfo->type == SBI_ITLB_FLUSH) ?
+		__ffs(TLB_DEFER_FENCE_I) : __ffs(TLB_DEFER_FLUSH_ALL);
+}
 
-	while (!sbi_fifo_dequeue(tlb_fifo, &tinfo))
-		sbi_tlb_entry_process(&tinfo);
+static void sbi_tlb_defer(u32 hartid, struct sbi_tlb_info *tinfo)
+{
+	struct sbi_scratch *rscratch = sbi_hartid_to_scratch(hartid);
+
+	if (!rscratch || sbi_hsm_hart_started(hartid))
+		return;
+
+	atomic_raw_set_bit(sbi_tlb_defer_bit(tinfo),
+			   sbi_scratch_offset_ptr(rscratch, tlb_deferred_off));
+	sbi_tlb_stats_inc(sbi_scratch_thishart_ptr(), deferred);
 }
 
-static void sbi_tlb_sync(struct sbi_scratch *scratch)
+/*
+ * Record request for every HART of the mask which is not started. The
+ * record is done before the started mask is sampled by the IPI layer so
+ * a HART which becomes started in between either sees the record in
+ * sbi_tlb_resume() or gets the IPI.
+ */
+static void sbi_tlb_defer_stopped_word(ulong hmask, ulong hbase,
+				       struct sbi_tlb_info *tinfo)
 {
-	unsigned long *tlb_sync =
-			sbi_scratch_offset_ptr(scratch, tlb_sync_off);
+	ulong i, started, hcount = sbi_scratch_last_hartid() + 1;
 
-	while (!atomic_raw_xchg_ulong(tlb_sync, 0)) {
-		/*
-		 * While we are waiting for remote hart to set the sync,
-		 * consume fifo requests to avoid deadlock.
-		 */
-		sbi_tlb_process_count(scratch, 1);
+	if (sbi_hsm_hart_started_mask(hbase, &started))
+		return;
+
+	hmask &= ~started;
+	if ((hcount - hbase) < BITS_PER_LONG)
+		hmask &= (1UL << (hcount - hbase)) - 1;
+
+	sbi_hmask_for_each_bit(i, hmask)
+		sbi_tlb_defer(hbase + i, tinfo);
+}
+
+static void sbi_tlb_defer_stopped(ulong hmask, ulong hbase,
+				  struct sbi_tlb_info *tinfo)
+{
+	ulong base, hcount = sbi_scratch_last_hartid() + 1;
+
+	if (hbase != -1UL) {
+		sbi_tlb_defer_stopped_word(hmask, hbase, tinfo);
+		return;
 	}
 
-	return;
+	/* Only visit HARTs missing from the started mask */
+	for (base = 0; base < hcount; base += BITS_PER_LONG)
+		sbi_tlb_defer_stopped_word(-1UL, base, tinfo);
 }
 
-static inline int __sbi_tlb_range_check(struct sbi_tlb_info *curr,
-					struct sbi_tlb_info *next)
+static inline bool sbi_tlb_is_vvma(struct sbi_tlb_info *tinfo)
 {
-	unsigned long curr_end;
-	unsigned long next_end;
-	int ret = SBI_FIFO_UNCHANGED;
+	return (tinfo->type == SBI_TLB_FLUSH_VVMA ||
+		tinfo->type == SBI_TLB_FLUSH_VVMA_ASID) ? TRUE : FALSE;
+}
 
-	if (!curr || !next)
-		return ret;
+/*
+ * Flush a batch of merged requests. VS-stage requests are grouped by
+ * VMID so that HGATP is switched once per group and restored only once
+ * for the whole batch.
+ */
+static void sbi_tlb_flush_batch(struct sbi_scratch *scratch,
+				struct sbi_tlb_info *flush, u32 count)
+{
+	u32 i, j, vmid_done = 0;
+	unsigned long hgatp = 0;
+	bool hgatp_saved = FALSE;
+	unsigned long cycles = sbi_tlb_stats_cycles();
+
+	for (i = 0; i < count; i++) {
+		if (!sbi_tlb_is_vvma(&flush[i])) {
+			sbi_tlb_local_flush(&flush[i]);
+			continue;
+		}
+		if (vmid_done & BIT(i))
+			continue;
 
-	next_end = next->start + next->size;
-	curr_end = curr->start + curr->size;
-	if (next->start <= curr->start && next_end > curr_end) {
-		curr->start = next->start;
-		curr->size  = next->size;
-		sbi_hartmask_or(&curr->smask, &curr->smask, &next->smask);
-		ret = SBI_FIFO_UPDATED;
-	} else if (next->start >= curr->start && next_end <= curr_end) {
-		sbi_hartmask_or(&curr->smask, &curr->smask, &next->smask);
-		ret = SBI_FIFO_SKIP;
+		if (!hgatp_saved) {
+			hgatp = csr_swap(CSR_HGATP,
+				sbi_tlb_hgatp_vmid(flush[i].vmid));
+			hgatp_saved = TRUE;
+		} else {
+			csr_write(CSR_HGATP,
+				  sbi_tlb_hgatp_vmid(flush[i].vmid));
+		}
+
+		for (j = i; j < count; j++) {
+			if (!sbi_tlb_is_vvma(&flush[j]) ||
+			    flush[j].vmid != flush[i].vmid)
+				continue;
+			sbi_tlb_count_upgrade(&flush[j]);
+			if (flush[j].type == SBI_TLB_FLUSH_VVMA)
+				__sbi_tlb_hfence_vvma(&flush[j]);
+			else
+				__sbi_tlb_hfence_vvma_asid(&flush[j]);
+			vmid_done |= BIT(j);
+		}
 	}
 
-	return ret;
+	if (hgatp_saved)
+		csr_write(CSR_HGATP, hgatp);
+
+	sbi_tlb_stats_hist_cycles(scratch, flush_hist, cycles);
 }
 
-/**
- * Call back to decide if an inplace fifo update is required or next entry can
- * can be skipped. Here are the different cases that are being handled.
- *
- * Case1:
- *	if next flush request range lies within one of the existing entry, skip
- *	the next entry.
- * Case2:
- *	if flush request range in current fifo entry lies within next flush
- *	request, update the current entry.
- *
- * Note:
- *	We can not issue a fifo reset anymore if a complete vma flush is requested.
- *	This is because we are queueing FENCE.I requests as well now.
- *	To ease up the pressure in enqueue/fifo sync path, try to dequeue 1 element
- *	before continuing the while loop. This method is preferred over wfi/ipi because
- *	of MMIO cost involved in later method.
- */
-static int sbi_tlb_update_cb(void *in, void *data)
+static void sbi_tlb_relay_finish(struct sbi_scratch *scratch)
 {
-	struct sbi_tlb_info *curr;
-	struct sbi_tlb_info *next;
-	int ret = SBI_FIFO_UNCHANGED;
+	struct sbi_tlb_desc *src;
+	struct sbi_wait w;
+	struct sbi_tlb_cluster *cl = sbi_tlb_cluster_ptr(scratch);
+
+	SBI_WAIT_INIT(&w, TRUE);
+	while (atomic_read(&cl->relay.pending)) {
+		/* Back off only while there is nothing else to do */
+		if (sbi_tlb_process_count(scratch, 1))
+			SBI_WAIT_INIT(&w, TRUE);
+		else
+			sbi_wait_relax(&w);
+	}
 
-	if (!in || !data)
-		return ret;
+	src = cl->relay_src;
+	cl->relay_src = NULL;
+	sbi_tlb_desc_done(src);
+}
 
-	curr = (struct sbi_tlb_info *)data;
-	next = (struct sbi_tlb_info *)in;
+static void sbi_tlb_process(struct sbi_scratch *scratch)
+{
+	int rule;
+	bool relay, relaying = FALSE;
+	u32 i, nflush = 0, ndone = 0;
+	struct sbi_tlb_info flush[SBI_TLB_MERGE_BATCH_MAX];
+	struct sbi_tlb_desc *desc, *done[SBI_TLB_MERGE_BATCH_MAX];
+	u64 now = 0;
+
+	sbi_tlb_overflow_process(scratch);
+
+	while (!sbi_tlb_dequeue(scratch, &desc, &relay, &now)) {
+		if (ndone == array_size(done) || nflush == array_size(flush)) {
+			sbi_tlb_flush_batch(scratch, flush, nflush);
+			now = 0;
+			for (i = 0; i < ndone; i++)
+				sbi_tlb_desc_done(done[i]);
+			nflush = ndone = 0;
+		}
+		if (relay && sbi_tlb_relay_start(scratch, desc))
+			relaying = TRUE;
+		else
+			done[ndone++] = desc;
+
+		/* Try to fold into any request of the batch */
+		for (i = 0; i < nflush; i++) {
+			rule = sbi_tlb_merge(&flush[i], &desc->tinfo);
+			if (rule != SBI_TLB_MERGE_NONE) {
+				sbi_tlb_stats_inc(scratch, merge[rule]);
+				break;
+			}
+		}
+		if (i == nflush)
+			sbi_memcpy(&flush[nflush++], &desc->tinfo,
+				   sizeof(desc->tinfo));
+	}
+
+	if (nflush)
+		sbi_tlb_flush_batch(scratch, flush, nflush);
+	for (i = 0; i < ndone; i++)
+		sbi_tlb_desc_done(done[i]);
 
-	if (next->type == SBI_TLB_FLUSH_VMA_ASID &&
-	    curr->type == SBI_TLB_FLUSH_VMA_ASID) {
-		if (next->asid == curr->asid)
-			ret = __sbi_tlb_range_check(curr, next);
-	} else if (next->type == SBI_TLB_FLUSH_VMA &&
-		   curr->type == SBI_TLB_FLUSH_VMA) {
-			ret = __sbi_tlb_range_check(curr, next);
+	/* Complete the relayed source once its cluster is done */
+	if (relaying)
+		sbi_tlb_relay_finish(scratch);
+}
+
+static void sbi_tlb_sync(struct sbi_scratch *scratch)
+{
+	struct sbi_tlb_desc *desc =
+			sbi_scratch_offset_ptr(scratch, tlb_desc_off);
+	unsigned long cycles = sbi_tlb_stats_cycles();
+	struct sbi_wait w;
+
+	SBI_WAIT_INIT(&w, TRUE);
+	while (atomic_read(&desc->pending)) {
+		/*
+		 * While we are waiting for remote harts to complete,
+		 * consume fifo requests to avoid deadlock. Relay HARTs
+		 * may be waiting on us so back off only while idle.
+		 */
+		if (sbi_tlb_process_count(scratch, 1))
+			SBI_WAIT_INIT(&w, TRUE);
+		else
+			sbi_wait_relax(&w);
 	}
 
-	return ret;
+	sbi_tlb_stats_hist_cycles(scratch, sync_hist, cycles);
 }
 
-static int sbi_tlb_update(struct sbi_scratch *scratch,
-			  struct sbi_scratch *remote_scratch,
-			  u32 remote_hartid, void *data)
+static int __sbi_tlb_update(struct sbi_scratch *scratch,
+			    struct sbi_scratch *remote_scratch,
+			    u32 remote_hartid, struct sbi_tlb_desc *desc,
+			    bool relay_ok)
 {
-	int ret;
-	struct sbi_fifo *tlb_fifo_r;
-	struct sbi_tlb_info *tinfo = data;
+	u32 cluster;
+	unsigned long entry = (unsigned long)desc;
+	struct sbi_mpsc_fifo *tlb_fifo_r;
+	volatile unsigned long *deferred;
 	u32 curr_hartid = current_hartid();
 
 	/*
-	 * If address range to flush is too big then simply
-	 * upgrade it to flush all because we can only flush
-	 * 4KB at a time.
+	 * If the request is to queue a tlb flush entry for itself
+	 * then just do a local flush and return;
 	 */
-	if (tinfo->size > tlb_range_flush_limit) {
-		tinfo->start = 0;
-		tinfo->size = SBI_TLB_FLUSH_ALL;
+	if (remote_hartid == curr_hartid) {
+		sbi_tlb_local_flush(&desc->tinfo);
+		return -1;
 	}
 
 	/*
-	 * If the request is to queue a tlb flush entry for itself
-	 * then just do a local flush and return;
+	 * If the remote HART is suspended then record the request for
+	 * its resume path instead of waking it up.
 	 */
-	if (remote_hartid == curr_hartid) {
-		sbi_tlb_local_flush(tinfo);
+	deferred = sbi_scratch_offset_ptr(remote_scratch, tlb_deferred_off);
+	if ((*deferred & TLB_DEFER_ACTIVE) &&
+	    (atomic_raw_set_bit(sbi_tlb_defer_bit(&desc->tinfo), deferred) &
+	     TLB_DEFER_ACTIVE)) {
+		sbi_tlb_stats_inc(scratch, deferred);
 		return -1;
 	}
 
 	tlb_fifo_r = sbi_scratch_offset_ptr(remote_scratch, tlb_fifo_off);
 
-	ret = sbi_fifo_inplace_update(tlb_fifo_r, data, sbi_tlb_update_cb);
-	if (ret != SBI_FIFO_UNCHANGED) {
-		return 1;
+	/*
+	 * HARTs of another cluster are reached through the first of them
+	 * which becomes the relay for the rest of its cluster. The IPI
+	 * layer visits the targets in ascending order.
+	 */
+	cluster = sbi_tlb_cluster_ptr(remote_scratch)->id;
+	if (relay_ok &&
+	    cluster != sbi_tlb_cluster_ptr(scratch)->id) {
+		if (sbi_hartmask_test_hart(cluster, &desc->relayed))
+			return -1;
+		sbi_hartmask_set_hart(cluster, &desc->relayed);
+		entry |= TLB_ENTRY_RELAY;
 	}
 
-	while (sbi_fifo_enqueue(tlb_fifo_r, data) < 0) {
-		/**
-		 * For now, Busy loop until there is space in the fifo.
-		 * There may be case where target hart is also
-		 * enqueue in source hart's fifo. Both hart may busy
-		 * loop leading to a deadlock.
-		 * TODO: Introduce a wait/wakeup event mechanism to handle
-		 * this properly.
-		 */
-		sbi_tlb_process_count(scratch, 1);
-		sbi_dprintf("hart%d: hart%d tlb fifo full\n",
-			    curr_hartid, remote_hartid);
-	}
+	atomic_add_return(&desc->pending, 1);
+	if (!sbi_mpsc_fifo_enqueue(tlb_fifo_r, &entry))
+		return 0;
+	sbi_tlb_stats_inc(scratch, fifo_full);
+
+	/*
+	 * The remote fifo is full so degrade the request to a flush of
+	 * everything in its scope instead of waiting for space. A relay
+	 * entry leaves the rest of its cluster to the next target.
+	 */
+	if (entry & TLB_ENTRY_RELAY)
+		sbi_hartmask_clear_hart(cluster, &desc->relayed);
+	sbi_tlb_overflow(remote_scratch, desc);
 
 	return 0;
 }
 
+static int sbi_tlb_update(struct sbi_scratch *scratch,
+			  struct sbi_scratch *remote_scratch,
+			  u32 remote_hartid, void *data)
+{
+	return __sbi_tlb_update(scratch, remote_scratch, remote_hartid,
+				data, tlb_clustered);
+}
+
+static int sbi_tlb_relay_update(struct sbi_scratch *scratch,
+				struct sbi_scratch *remote_scratch,
+				u32 remote_hartid, void *data)
+{
+	return __sbi_tlb_update(scratch, remote_scratch, remote_hartid,
+				data, FALSE);
+}
+
 static struct sbi_ipi_event_ops tlb_ops = {
 	.name = "IPI_TLB",
 	.update = sbi_tlb_update,
@@ -389,64 +1143,402 @@ static struct sbi_ipi_event_ops tlb_ops = {
 
 static u32 tlb_event = SBI_IPI_EVENT_MAX;
 
+/* Requests forwarded by a relay HART, the relay HART waits by itself */
+static struct sbi_ipi_event_ops tlb_relay_ops = {
+	.name = "IPI_TLB_RELAY",
+	.update = sbi_tlb_relay_update,
+	.process = sbi_tlb_process,
+};
+
 int sbi_tlb_request(ulong hmask, ulong hbase, struct sbi_tlb_info *tinfo)
 {
-	return sbi_ipi_send_many(hmask, hbase, tlb_event, tinfo);
+	struct sbi_tlb_desc *desc =
+			sbi_scratch_offset_ptr(sbi_scratch_thishart_ptr(),
+					       tlb_desc_off);
+
+	/*
+	 * Publish a single descriptor in our own scratch space. Each
+	 * target gets a pointer to it and the sync callback waits only
+	 * once for all of them to complete.
+	 */
+	sbi_memcpy(&desc->tinfo, tinfo, sizeof(desc->tinfo));
+	sbi_tlb_stats_stamp(desc);
+	atomic_write(&desc->pending, 0);
+	if (tlb_clustered) {
+		desc->target_mask = hmask;
+		desc->target_base = hbase;
+		SBI_HARTMASK_INIT(&desc->relayed);
+	}
+
+	if (tinfo->type <= SBI_ITLB_FLUSH)
+		sbi_tlb_stats_inc(sbi_scratch_thishart_ptr(),
+				  request[tinfo->type]);
+
+	sbi_tlb_defer_stopped(hmask, hbase, tinfo);
+
+	return sbi_ipi_send_many(hmask, hbase, tlb_event, desc);
+}
+
+void sbi_tlb_suspend(struct sbi_scratch *scratch)
+{
+	if (!tlb_deferred_off)
+		return;
+
+	atomic_raw_set_bit(__ffs(TLB_DEFER_ACTIVE),
+		sbi_scratch_offset_ptr(scratch, tlb_deferred_off));
+}
+
+void sbi_tlb_resume(struct sbi_scratch *scratch)
+{
+	unsigned long deferred;
+
+	if (!tlb_deferred_off)
+		return;
+
+	deferred = atomic_raw_xchg_ulong(
+			sbi_scratch_offset_ptr(scratch, tlb_deferred_off), 0);
+
+	if (deferred & TLB_DEFER_FLUSH_ALL) {
+		sbi_tlb_flush_all();
+		if (misa_extension('H')) {
+			__sbi_hfence_gvma_all();
+			__sbi_hfence_vvma_all();
+		}
+	}
+	if (deferred & TLB_DEFER_FENCE_I)
+		__asm__ __volatile("fence.i");
+
+	/* Consume requests queued before we were marked as suspended */
+	if (deferred & TLB_DEFER_ACTIVE)
+		sbi_tlb_process(scratch);
+}
+
+#ifdef SBI_IPI_STATS
+
+static struct sbi_scratch *sbi_tlb_stats_scratch(u32 hartid)
+{
+	/* HART id comes from S-mode so check it before the table lookup */
+	if (SBI_HARTMASK_MAX_BITS <= hartid ||
+	    sbi_scratch_last_hartid() < hartid)
+		return NULL;
+
+	return sbi_hartid_to_scratch(hartid);
+}
+
+int sbi_tlb_stats_read(u32 hartid, unsigned long index,
+		       unsigned long *out_val)
+{
+	struct sbi_scratch *rscratch = sbi_tlb_stats_scratch(hartid);
+
+	if (!rscratch || !tlb_stats_off || SBI_TLB_STATS_WORDS <= index)
+		return SBI_EINVAL;
+
+	*out_val = ((unsigned long *)sbi_tlb_stats_ptr(rscratch))[index];
+
+	return 0;
+}
+
+int sbi_tlb_stats_reset(u32 hartid)
+{
+	struct sbi_scratch *rscratch = sbi_tlb_stats_scratch(hartid);
+
+	if (!rscratch || !tlb_stats_off)
+		return SBI_EINVAL;
+
+	sbi_memset(sbi_tlb_stats_ptr(rscratch), 0,
+		   sizeof(struct sbi_tlb_stats));
+
+	return 0;
+}
+
+static void sbi_tlb_hist_dump(u32 hartid, const char *name,
+			      unsigned long *hist)
+{
+	int i;
+
+	sbi_dprintf("hart%d: tlb %s:", hartid, name);
+	for (i = 0; i < SBI_TLB_HIST_BUCKETS; i++)
+		sbi_dprintf(" %lu", hist[i]);
+	sbi_dprintf("\n");
+}
+
+void sbi_tlb_stats_dump(struct sbi_scratch *scratch)
+{
+	u32 hartid = current_hartid();
+	struct sbi_tlb_stats *stats;
+
+	if (!tlb_stats_off)
+		return;
+	stats = sbi_tlb_stats_ptr(scratch);
+
+	sbi_dprintf("hart%d: tlb requests: vma=%lu vma_asid=%lu gvma=%lu "
+		    "gvma_vmid=%lu vvma=%lu vvma_asid=%lu fence_i=%lu\n",
+		    hartid, stats->request[SBI_TLB_FLUSH_VMA],
+		    stats->request[SBI_TLB_FLUSH_VMA_ASID],
+		    stats->request[SBI_TLB_FLUSH_GVMA],
+		    stats->request[SBI_TLB_FLUSH_GVMA_VMID],
+		    stats->request[SBI_TLB_FLUSH_VVMA],
+		    stats->request[SBI_TLB_FLUSH_VVMA_ASID],
+		    stats->request[SBI_ITLB_FLUSH]);
+	sbi_dprintf("hart%d: tlb merges: range=%lu contain=%lu "
+		    "flush_all=%lu fence_i=%lu\n",
+		    hartid, stats->merge[SBI_TLB_MERGE_RANGE],
+		    stats->merge[SBI_TLB_MERGE_CONTAIN],
+		    stats->merge[SBI_TLB_MERGE_FLUSH_ALL],
+		    stats->merge[SBI_TLB_MERGE_FENCE_I]);
+	sbi_dprintf("hart%d: tlb fifo_full=%lu upgrade=%lu deferred=%lu\n",
+		    hartid, stats->fifo_full, stats->upgrade, stats->deferred);
+	sbi_tlb_hist_dump(hartid, "sync cycles", stats->sync_hist);
+	sbi_tlb_hist_dump(hartid, "flush cycles", stats->flush_hist);
+	sbi_tlb_hist_dump(hartid, "delivery ticks", stats->delivery_hist);
+}
+
+#else
+
+int sbi_tlb_stats_read(u32 hartid, unsigned long index,
+		       unsigned long *out_val)
+{
+	return SBI_ENOTSUPP;
+}
+
+int sbi_tlb_stats_reset(u32 hartid)
+{
+	return SBI_ENOTSUPP;
+}
+
+void sbi_tlb_stats_dump(struct sbi_scratch *scratch)
+{
+}
+
+#endif
+
+static unsigned long sbi_tlb_calibrate_type(unsigned long type)
+{
+	u32 hartid = current_hartid();
+	struct sbi_tlb_info tinfo;
+	unsigned long i, t, t_all = -1UL, t_range = -1UL;
+
+	for (i = 0; i < TLB_CALIBRATE_ROUNDS; i++) {
+		SBI_TLB_INFO_INIT(&tinfo, 0, SBI_TLB_FLUSH_ALL, 0, 0,
+				  type, hartid);
+		t = csr_read(CSR_MCYCLE);
+		sbi_tlb_local_flush(&tinfo);
+		t = csr_read(CSR_MCYCLE) - t;
+		if (t < t_all)
+			t_all = t;
+
+		SBI_TLB_INFO_INIT(&tinfo, PAGE_SIZE,
+				  TLB_CALIBRATE_PAGES * PAGE_SIZE, 0, 0,
+				  type, hartid);
+		t = csr_read(CSR_MCYCLE);
+		sbi_tlb_local_flush(&tinfo);
+		t = csr_read(CSR_MCYCLE) - t;
+		if (t < t_range)
+			t_range = t;
+	}
+
+	/*
+	 * Number of pages for which per-page invalidation costs as much
+	 * as a full flush. The refill cost after a full flush is not
+	 * visible here so this is a lower bound for the crossover point.
+	 */
+	if (!t_range)
+		return SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_DEFAULT;
+	t = (t_all * TLB_CALIBRATE_PAGES) / t_range;
+
+	return (t ? t : 1) * PAGE_SIZE;
+}
+
+static void sbi_tlb_calibrate(struct sbi_scratch *scratch)
+{
+	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
+	struct sbi_tlb_limit *limit =
+			sbi_scratch_offset_ptr(scratch, tlb_limit_off);
+	u64 plimit;
+
+	if (limit->calibrated)
+		return;
+
+	/* Calibrate only when the platform asks for it */
+	plimit = sbi_platform_tlbr_flush_limit(plat);
+	if (plimit != SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_CALIBRATE) {
+		limit->vma = plimit;
+		limit->gvma = plimit;
+		limit->vvma = plimit;
+		limit->calibrated = TRUE;
+		return;
+	}
+
+	/* Force per-page invalidation while timing */
+	limit->vma = -1UL;
+	limit->gvma = -1UL;
+	limit->vvma = -1UL;
+
+	limit->vma = sbi_tlb_calibrate_type(SBI_TLB_FLUSH_VMA);
+	if (misa_extension('H')) {
+		limit->gvma = sbi_tlb_calibrate_type(SBI_TLB_FLUSH_GVMA);
+		limit->vvma = sbi_tlb_calibrate_type(SBI_TLB_FLUSH_VVMA);
+	} else {
+		limit->gvma = limit->vma;
+		limit->vvma = limit->vma;
+	}
+	limit->calibrated = TRUE;
+}
+
+/* Record the cluster of every HART as reported by the platform */
+static void sbi_tlb_cluster_init(const struct sbi_platform *plat)
+{
+	u32 i, id, last_hartid = sbi_scratch_last_hartid();
+	struct sbi_scratch *rscratch;
+	struct sbi_tlb_cluster *cl;
+
+	for (i = 0; i <= last_hartid && i < SBI_HARTMASK_MAX_BITS; i++) {
+		rscratch = sbi_hartid_to_scratch(i);
+		if (!rscratch)
+			continue;
+		SBI_HARTMASK_INIT(&sbi_tlb_cluster_ptr(rscratch)->members);
+	}
+
+	for (i = 0; i <= last_hartid && i < SBI_HARTMASK_MAX_BITS; i++) {
+		rscratch = sbi_hartid_to_scratch(i);
+		if (!rscratch)
+			continue;
+		id = sbi_platform_hart_cluster(plat, i);
+		if (id > i || !sbi_hartid_to_scratch(id))
+			id = i;
+		cl = sbi_tlb_cluster_ptr(rscratch);
+		cl->id = id;
+		sbi_hartmask_set_hart(i, &sbi_tlb_cluster_ptr(
+				sbi_hartid_to_scratch(id))->members);
+		if (id != i)
+			tlb_clustered = TRUE;
+	}
 }
 
 int sbi_tlb_init(struct sbi_scratch *scratch, bool cold_boot)
 {
-	int ret;
+	int ret = SBI_ENOMEM;
+	u32 num_entries;
 	void *tlb_mem;
-	unsigned long *tlb_sync;
-	struct sbi_fifo *tlb_q;
+	struct sbi_tlb_desc *desc;
+	struct sbi_mpsc_fifo *tlb_q;
+	struct sbi_tlb_overflow *ovf;
+	struct sbi_tlb_cluster *cl;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
 	if (cold_boot) {
-		tlb_sync_off = sbi_scratch_alloc_offset(sizeof(*tlb_sync),
-							"IPI_TLB_SYNC");
-		if (!tlb_sync_off)
+		tlb_desc_off = sbi_scratch_alloc_offset(sizeof(*desc),
+							"IPI_TLB_DESC");
+		if (!tlb_desc_off)
 			return SBI_ENOMEM;
 		tlb_fifo_off = sbi_scratch_alloc_offset(sizeof(*tlb_q),
 							"IPI_TLB_FIFO");
-		if (!tlb_fifo_off) {
-			sbi_scratch_free_offset(tlb_sync_off);
-			return SBI_ENOMEM;
-		}
+		if (!tlb_fifo_off)
+			goto fail_free_desc;
+		num_entries = sbi_platform_tlb_fifo_num_entries(plat);
+		if (num_entries > SBI_TLB_FIFO_NUM_ENTRIES_MAX)
+			num_entries = SBI_TLB_FIFO_NUM_ENTRIES_MAX;
+		if (num_entries < SBI_TLB_FIFO_NUM_ENTRIES_MIN)
+			num_entries = SBI_TLB_FIFO_NUM_ENTRIES_MIN;
+		tlb_fifo_num_entries = 1U << (fls(num_entries) - 1);
 		tlb_fifo_mem_off = sbi_scratch_alloc_offset(
-				SBI_TLB_FIFO_NUM_ENTRIES * SBI_TLB_INFO_SIZE,
+				SBI_MPSC_FIFO_MEM_SIZE(tlb_fifo_num_entries,
+						       sizeof(desc)),
 				"IPI_TLB_FIFO_MEM");
-		if (!tlb_fifo_mem_off) {
-			sbi_scratch_free_offset(tlb_fifo_off);
-			sbi_scratch_free_offset(tlb_sync_off);
-			return SBI_ENOMEM;
-		}
+		if (!tlb_fifo_mem_off)
+			goto fail_free_fifo;
+		tlb_overflow_off = sbi_scratch_alloc_offset(sizeof(*ovf),
+							"IPI_TLB_OVERFLOW");
+		if (!tlb_overflow_off)
+			goto fail_free_fifo_mem;
+		tlb_deferred_off = sbi_scratch_alloc_offset(
+				sizeof(unsigned long), "IPI_TLB_DEFERRED");
+		if (!tlb_deferred_off)
+			goto fail_free_overflow;
+		tlb_limit_off = sbi_scratch_alloc_offset(
+				sizeof(struct sbi_tlb_limit), "IPI_TLB_LIMIT");
+		if (!tlb_limit_off)
+			goto fail_free_deferred;
+		tlb_cluster_off = sbi_scratch_alloc_offset(
+				sizeof(struct sbi_tlb_cluster), "IPI_TLB_CLUSTER");
+		if (!tlb_cluster_off)
+			goto fail_free_limit;
+#ifdef SBI_IPI_STATS
+		tlb_stats_off = sbi_scratch_alloc_offset(
+				sizeof(struct sbi_tlb_stats), "IPI_TLB_STATS");
+		if (!tlb_stats_off)
+			goto fail_free_cluster;
+#endif
 		ret = sbi_ipi_event_create(&tlb_ops);
-		if (ret < 0) {
-			sbi_scratch_free_offset(tlb_fifo_mem_off);
-			sbi_scratch_free_offset(tlb_fifo_off);
-			sbi_scratch_free_offset(tlb_sync_off);
-			return ret;
-		}
+		if (ret < 0)
+			goto fail_free_stats;
 		tlb_event = ret;
-		tlb_range_flush_limit = sbi_platform_tlbr_flush_limit(plat);
+		sbi_tlb_cluster_init(plat);
+		if (tlb_clustered) {
+			ret = sbi_ipi_event_create(&tlb_relay_ops);
+			if (ret < 0)
+				goto fail_destroy_event;
+			tlb_relay_event = ret;
+		}
 	} else {
-		if (!tlb_sync_off ||
+		if (!tlb_desc_off ||
 		    !tlb_fifo_off ||
-		    !tlb_fifo_mem_off)
+		    !tlb_fifo_mem_off ||
+		    !tlb_overflow_off ||
+		    !tlb_deferred_off ||
+		    !tlb_limit_off ||
+		    !tlb_cluster_off)
 			return SBI_ENOMEM;
-		if (SBI_IPI_EVENT_MAX <= tlb_event)
+#ifdef SBI_IPI_STATS
+		if (!tlb_stats_off)
+			return SBI_ENOMEM;
+#endif
+		if (SBI_IPI_EVENT_MAX <= tlb_event ||
+		    (tlb_clustered && SBI_IPI_EVENT_MAX <= tlb_relay_event))
 			return SBI_ENOSPC;
 	}
 
-	tlb_sync = sbi_scratch_offset_ptr(scratch, tlb_sync_off);
+	desc = sbi_scratch_offset_ptr(scratch, tlb_desc_off);
 	tlb_q = sbi_scratch_offset_ptr(scratch, tlb_fifo_off);
 	tlb_mem = sbi_scratch_offset_ptr(scratch, tlb_fifo_mem_off);
-
-	*tlb_sync = 0;
-
-	sbi_fifo_init(tlb_q, tlb_mem,
-		      SBI_TLB_FIFO_NUM_ENTRIES, SBI_TLB_INFO_SIZE);
-
-	return 0;
+	ovf = sbi_scratch_offset_ptr(scratch, tlb_overflow_off);
+	cl = sbi_tlb_cluster_ptr(scratch);
+
+	sbi_tlb_calibrate(scratch);
+
+	ATOMIC_INIT(&desc->pending, 0);
+	desc->hartid = current_hartid();
+	desc->relay = FALSE;
+	ATOMIC_INIT(&cl->relay.pending, 0);
+	cl->relay.hartid = current_hartid();
+	cl->relay.relay = TRUE;
+	cl->relay_src = NULL;
+	ovf->scope = 0;
+	SBI_HARTMASK_INIT(&ovf->srcs);
+	SBI_HARTMASK_INIT(&ovf->relays);
+
+	return sbi_mpsc_fifo_init(tlb_q, tlb_mem,
+				  tlb_fifo_num_entries, sizeof(desc));
+
+fail_destroy_event:
+	sbi_ipi_event_destroy(tlb_event);
+fail_free_stats:
+#ifdef SBI_IPI_STATS
+	sbi_scratch_free_offset(tlb_stats_off);
+fail_free_cluster:
+#endif
+	sbi_scratch_free_offset(tlb_cluster_off);
+fail_free_limit:
+	sbi_scratch_free_offset(tlb_limit_off);
+fail_free_deferred:
+	sbi_scratch_free_offset(tlb_deferred_off);
+fail_free_overflow:
+	sbi_scratch_free_offset(tlb_overflow_off);
+fail_free_fifo_mem:
+	sbi_scratch_free_offset(tlb_fifo_mem_off);
+fail_free_fifo:
+	sbi_scratch_free_offset(tlb_fifo_off);
+fail_free_desc:
+	sbi_scratch_free_offset(tlb_desc_off);
+	return ret;
 }
@@ -195,6 +195,43 @@ int sbi_trap_redirect(struct sbi_trap_regs *regs,
 	return 0;
 }
 
+static int sbi_trap_irq(ulong irq)
+{
+	switch (irq) {
+	case IRQ_M_TIMER:
+		sbi_timer_process();
+		break;
+	case IRQ_M_SOFT:
+		sbi_ipi_process();
+		break;
+	case IRQ_M_PMU:
+		csr_clear(CSR_MIE, MIP_MOVFIP);
+		csr_set(CSR_SLIP, MIP_MOVFIP);
+		break;
+	default:
+		return SBI_ENOTSUPP;
+	};
+
+	return 0;
+}
+
+/**
+ * Handle M-mode interrupt
+ *
+ * This is called from the trap entry with only caller saved registers
+ * preserved so it must not look at the interrupted register state.
+ * Non-zero return value makes the trap entry fall back to the full
+ * sbi_trap_handler() path which reports the unhandled interrupt.
+ *
+ * @param mcause the trap cause (with interrupt bit set)
+ *
+ * @return 0 if interrupt was handled and SBI_Exxx error otherwise
+ */
+int sbi_trap_irq_handler(ulong mcause)
+{
+	return sbi_trap_irq(mcause & ~(1UL << (__riscv_xlen - 1)));
+}
+
 /**
  * Handle trap/interrupt
  *
@@ -227,21 +264,11 @@ void sbi_trap_handler(struct sbi_trap_regs *regs)
 
 	if (mcause & (1UL << (__riscv_xlen - 1))) {
 		mcause &= ~(1UL << (__riscv_xlen - 1));
-		switch (mcause) {
-		case IRQ_M_TIMER:
-			sbi_timer_process();
-			break;
-		case IRQ_M_SOFT:
-			sbi_ipi_process();
-			break;
-		case IRQ_M_PMU:
-			csr_clear(CSR_MIE, MIP_MOVFIP);
-			csr_set(CSR_SLIP, MIP_MOVFIP);
-            break;
-		default:
+		rc = sbi_trap_irq(mcause);
+		if (rc) {
 			msg = "unhandled external interrupt";
 			goto trap_error;
-		};
+		}
 		return;
 	}
 
@@ -0,0 +1,35 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Polite waiting for a condition set by another HART.
+ */
+
+#include <sbi/sbi_platform.h>
+#include <sbi/sbi_wait.h>
+
+/**
+ * Back off once before the condition is checked again. The number of
+ * pause hints doubles on every step up to SBI_WAIT_BACKOFF_MAX. After
+ * that, event waits sleep on the platform event mechanism when there
+ * is one and keep backing off otherwise.
+ */
+void sbi_wait_relax(struct sbi_wait *w)
+{
+	unsigned long i;
+
+	if (w->backoff >= SBI_WAIT_BACKOFF_MAX && w->event &&
+	    sbi_platform_wait_event(sbi_platform_thishart_ptr()))
+		return;
+
+	for (i = 0; i < w->backoff; i++)
+		sbi_cpu_relax();
+
+	if (w->backoff < SBI_WAIT_BACKOFF_MAX)
+		w->backoff <<= 1;
+}
+
+/** Wake up HARTs waiting for an event condition */
+void sbi_wait_signal(void)
+{
+	sbi_platform_signal_event(sbi_platform_thishart_ptr());
+}
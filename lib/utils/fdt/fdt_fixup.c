@@ -218,10 +218,33 @@ int fdt_reserved_memory_fixup(void *fdt)
 	return 0;
 }
 
+void fdt_aclint_fixup(void *fdt)
+{
+	int err, noff;
+
+	err = fdt_open_into(fdt, fdt, fdt_totalsize(fdt) + 128);
+	if (err < 0)
+		return;
+
+	/* S-mode can raise supervisor software interrupts directly */
+	noff = -1;
+	while ((noff = fdt_node_offset_by_compatible(fdt, noff,
+					"riscv,aclint-sswi")) >= 0)
+		fdt_setprop_string(fdt, noff, "status", "okay");
+
+	/* M-mode software interrupts are owned by OpenSBI */
+	noff = -1;
+	while ((noff = fdt_node_offset_by_compatible(fdt, noff,
+					"riscv,aclint-mswi")) >= 0)
+		fdt_setprop_string(fdt, noff, "status", "disabled");
+}
+
 void fdt_fixups(void *fdt)
 {
 	fdt_plic_fixup(fdt, "riscv,plic0");
 
+	fdt_aclint_fixup(fdt);
+
 	fdt_reserved_memory_fixup(fdt);
 }
 
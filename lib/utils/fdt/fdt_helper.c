@@ -12,6 +12,7 @@
 #include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_scratch.h>
+#include <sbi/sbi_string.h>
 #include <sbi_utils/fdt/fdt_helper.h>
 #include <sbi_utils/irqchip/plic.h>
 #include <sbi_utils/sys/clint.h>
@@ -68,14 +69,17 @@ int fdt_find_match(void *fdt, int startoff,
 	return SBI_ENODEV;
 }
 
-int fdt_get_node_addr_size(void *fdt, int node, unsigned long *addr,
-			   unsigned long *size)
+int fdt_get_node_addr_size_by_index(void *fdt, int node, int index,
+				    unsigned long *addr, unsigned long *size)
 {
 	int parent, len, i;
 	int cell_addr, cell_size;
 	const fdt32_t *prop_addr, *prop_size;
 	uint64_t temp = 0;
 
+	if (index < 0)
+		return SBI_EINVAL;
+
 	parent = fdt_parent_offset(fdt, node);
 	if (parent < 0)
 		return parent;
@@ -90,6 +94,9 @@ int fdt_get_node_addr_size(void *fdt, int node, unsigned long *addr,
 	prop_addr = fdt_getprop(fdt, node, "reg", &len);
 	if (!prop_addr)
 		return SBI_ENODEV;
+	if (len < (index + 1) * (cell_addr + cell_size) * sizeof(fdt32_t))
+		return SBI_ENODEV;
+	prop_addr += index * (cell_addr + cell_size);
 	prop_size = prop_addr + cell_addr;
 
 	if (addr) {
@@ -108,6 +115,12 @@ int fdt_get_node_addr_size(void *fdt, int node, unsigned long *addr,
 	return 0;
 }
 
+int fdt_get_node_addr_size(void *fdt, int node, unsigned long *addr,
+			   unsigned long *size)
+{
+	return fdt_get_node_addr_size_by_index(fdt, node, 0, addr, size);
+}
+
 int fdt_parse_hart_id(void *fdt, int cpu_offset, u32 *hartid)
 {
 	int len;
@@ -164,6 +177,94 @@ int fdt_parse_max_hart_id(void *fdt, u32 *max_hartid)
 	return 0;
 }
 
+static int fdt_find_hart(void *fdt, int cpus_offset, u32 hartid)
+{
+	u32 hid;
+	int cpu_offset;
+
+	fdt_for_each_subnode(cpu_offset, fdt, cpus_offset) {
+		if (!fdt_parse_hart_id(fdt, cpu_offset, &hid) && hid == hartid)
+			return cpu_offset;
+	}
+
+	return SBI_ENOENT;
+}
+
+static int fdt_cpu_map_hart_id(void *fdt, int map_node, u32 *hartid)
+{
+	int len;
+	const fdt32_t *val;
+
+	val = fdt_getprop(fdt, map_node, "cpu", &len);
+	if (!val || len < sizeof(fdt32_t))
+		return SBI_ENOENT;
+
+	return fdt_parse_hart_id(fdt,
+			fdt_node_offset_by_phandle(fdt, fdt32_to_cpu(*val)),
+			hartid);
+}
+
+/*
+ * Find the innermost cpu-map cluster containing the given HART and
+ * return the lowest HART id found under that cluster.
+ */
+int fdt_parse_hart_cluster(void *fdt, u32 hartid, u32 *cluster_hartid)
+{
+	u32 hid, min_hartid;
+	const char *name;
+	int cpus_offset, map_offset, cpu_offset, cluster, node, depth;
+
+	if (!fdt || !cluster_hartid)
+		return SBI_EINVAL;
+
+	cpus_offset = fdt_path_offset(fdt, "/cpus");
+	if (cpus_offset < 0)
+		return cpus_offset;
+
+	map_offset = fdt_subnode_offset(fdt, cpus_offset, "cpu-map");
+	if (map_offset < 0)
+		return SBI_ENOENT;
+
+	cpu_offset = fdt_find_hart(fdt, cpus_offset, hartid);
+	if (cpu_offset < 0)
+		return cpu_offset;
+
+	/* Find the core or thread node of the HART */
+	depth = 0;
+	node = map_offset;
+	do {
+		node = fdt_next_node(fdt, node, &depth);
+		if (node < 0 || depth <= 0)
+			return SBI_ENOENT;
+	} while (fdt_cpu_map_hart_id(fdt, node, &hid) || hid != hartid);
+
+	/* Walk up to the enclosing cluster node */
+	cluster = node;
+	do {
+		cluster = fdt_parent_offset(fdt, cluster);
+		if (cluster < 0 || cluster == map_offset)
+			return SBI_ENOENT;
+		name = fdt_get_name(fdt, cluster, NULL);
+	} while (!name || sbi_strnlen(name, 7) < 7 ||
+		 sbi_memcmp(name, "cluster", 7));
+
+	/* Lowest HART id under the cluster identifies it */
+	min_hartid = hartid;
+	depth = 0;
+	node = cluster;
+	while (1) {
+		node = fdt_next_node(fdt, node, &depth);
+		if (node < 0 || depth <= 0)
+			break;
+		if (!fdt_cpu_map_hart_id(fdt, node, &hid) && hid < min_hartid)
+			min_hartid = hid;
+	}
+
+	*cluster_hartid = min_hartid;
+
+	return 0;
+}
+
 int fdt_parse_sifive_uart_node(void *fdt, int nodeoffset,
 			       struct platform_uart_data *uart)
 {
@@ -365,6 +466,74 @@ int fdt_parse_clint_node(void *fdt, int nodeoffset, bool for_timer,
 	return 0;
 }
 
+int fdt_parse_aclint_node(void *fdt, int nodeoffset, u32 match_hwirq,
+			  unsigned long *out_addr, unsigned long *out_size,
+			  u32 *out_first_hartid, u32 *out_hart_count)
+{
+	const fdt32_t *val;
+	unsigned long reg_addr, reg_size;
+	int i, rc, count, cpu_offset, cpu_intc_offset;
+	u32 phandle, hwirq, hartid, first_hartid, last_hartid, hart_count;
+
+	if (nodeoffset < 0 || !fdt ||
+	    !out_addr || !out_size || !out_first_hartid || !out_hart_count)
+		return SBI_EINVAL;
+
+	rc = fdt_get_node_addr_size(fdt, nodeoffset, &reg_addr, &reg_size);
+	if (rc < 0 || !reg_size)
+		return SBI_ENODEV;
+
+	val = fdt_getprop(fdt, nodeoffset, "interrupts-extended", &count);
+	if (!val || count < sizeof(fdt32_t))
+		return SBI_EINVAL;
+	count = count / sizeof(fdt32_t);
+
+	first_hartid = -1U;
+	last_hartid = 0;
+	hart_count = 0;
+	for (i = 0; i < (count - 1); i += 2) {
+		phandle = fdt32_to_cpu(val[i]);
+		hwirq = fdt32_to_cpu(val[i + 1]);
+		if (hwirq != match_hwirq)
+			continue;
+
+		cpu_intc_offset = fdt_node_offset_by_phandle(fdt, phandle);
+		if (cpu_intc_offset < 0)
+			continue;
+
+		cpu_offset = fdt_parent_offset(fdt, cpu_intc_offset);
+		if (cpu_offset < 0)
+			continue;
+
+		rc = fdt_parse_hart_id(fdt, cpu_offset, &hartid);
+		if (rc)
+			continue;
+
+		if (SBI_HARTMASK_MAX_BITS <= hartid)
+			continue;
+
+		if (hartid < first_hartid)
+			first_hartid = hartid;
+		if (hartid > last_hartid)
+			last_hartid = hartid;
+		hart_count++;
+	}
+
+	if ((last_hartid < first_hartid) || first_hartid == -1U)
+		return SBI_ENODEV;
+
+	count = last_hartid - first_hartid + 1;
+	if (hart_count < count)
+		hart_count = count;
+
+	*out_addr = reg_addr;
+	*out_size = reg_size;
+	*out_first_hartid = first_hartid;
+	*out_hart_count = hart_count;
+
+	return 0;
+}
+
 int fdt_parse_compat_addr(void *fdt, unsigned long *addr,
 			  const char *compatible)
 {
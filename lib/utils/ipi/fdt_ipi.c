@@ -7,10 +7,24 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/ipi/aclint_sswi.h>
 #include <sbi_utils/ipi/fdt_ipi.h>
 
+#define ACLINT_SSWI_MAX_NR			16
+
+static unsigned long sswi_count = 0;
+static struct aclint_sswi_data sswi[ACLINT_SSWI_MAX_NR];
+
+static const struct fdt_match sswi_match[] = {
+	{ .compatible = "riscv,aclint-sswi" },
+	{ },
+};
+
 extern struct fdt_ipi fdt_ipi_clint;
 
 static struct fdt_ipi *ipi_drivers[] = {
@@ -31,6 +45,7 @@ static struct fdt_ipi dummy = {
 	.warm_init = NULL,
 	.exit = NULL,
 	.send = dummy_send,
+	.send_mask = NULL,
 	.clear = dummy_clear
 };
 
@@ -41,6 +56,27 @@ void fdt_ipi_send(u32 target_hart)
 	current_driver->send(target_hart);
 }
 
+void fdt_ipi_send_mask(ulong hmask, ulong hbase)
+{
+	ulong i;
+
+	if (current_driver->send_mask) {
+		current_driver->send_mask(hmask, hbase);
+		return;
+	}
+
+	sbi_hmask_for_each_bit(i, hmask)
+		current_driver->send(hbase + i);
+}
+
+int fdt_ipi_smode_send(u32 target_hart)
+{
+	if (!sswi_count)
+		return SBI_ENODEV;
+
+	return aclint_sswi_send(target_hart);
+}
+
 void fdt_ipi_clear(u32 target_hart)
 {
 	current_driver->clear(target_hart);
@@ -59,6 +95,37 @@ static int fdt_ipi_warm_init(void)
 	return 0;
 }
 
+/*
+ * Probe ACLINT SSWI devices. They are optional, S-mode IPIs are
+ * injected through the M-mode IPI driver for HARTs without one.
+ */
+static int fdt_ipi_sswi_cold_init(void *fdt)
+{
+	int noff, rc;
+	struct aclint_sswi_data *ss;
+	const struct fdt_match *match;
+
+	noff = -1;
+	while ((noff = fdt_find_match(fdt, noff, sswi_match, &match)) >= 0) {
+		if (ACLINT_SSWI_MAX_NR <= sswi_count)
+			return SBI_ENOSPC;
+		ss = &sswi[sswi_count];
+
+		rc = fdt_parse_aclint_node(fdt, noff, IRQ_S_SOFT,
+					   &ss->addr, &ss->size,
+					   &ss->first_hartid, &ss->hart_count);
+		if (rc)
+			continue;
+
+		rc = aclint_sswi_cold_init(ss);
+		if (rc)
+			return rc;
+		sswi_count++;
+	}
+
+	return 0;
+}
+
 static int fdt_ipi_cold_init(void)
 {
 	int pos, noff, rc;
@@ -66,6 +133,10 @@ static int fdt_ipi_cold_init(void)
 	const struct fdt_match *match;
 	void *fdt = sbi_scratch_thishart_arg1_ptr();
 
+	rc = fdt_ipi_sswi_cold_init(fdt);
+	if (rc)
+		return rc;
+
 	for (pos = 0; pos < array_size(ipi_drivers); pos++) {
 		drv = ipi_drivers[pos];
 
@@ -45,5 +45,6 @@ struct fdt_ipi fdt_ipi_clint = {
 	.warm_init = clint_warm_ipi_init,
 	.exit = NULL,
 	.send = clint_ipi_send,
+	.send_mask = clint_ipi_send_mask,
 	.clear = clint_ipi_clear,
 };
@@ -34,6 +34,25 @@ void clint_ipi_send(u32 target_hart)
 	writel(1, &clint->ipi[target_hart - clint->first_hartid]);
 }
 
+void clint_ipi_send_mask(ulong hmask, ulong hbase)
+{
+	ulong i;
+	struct clint_data *clint;
+
+	/* Order memory writes once and then ring all doorbells */
+	__io_bw();
+	sbi_hmask_for_each_bit(i, hmask) {
+		if (SBI_HARTMASK_MAX_BITS <= (hbase + i))
+			break;
+		clint = clint_ipi_hartid2data[hbase + i];
+		if (!clint)
+			continue;
+
+		/* Set CLINT IPI */
+		__raw_writel(1, &clint->ipi[hbase + i - clint->first_hartid]);
+	}
+}
+
 void clint_ipi_clear(u32 target_hart)
 {
 	struct clint_data *clint;
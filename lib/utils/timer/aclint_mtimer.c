@@ -0,0 +1,180 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * RISC-V ACLINT machine-level timer (MTIMER) device.
+ *
+ * Unlike the SiFive CLINT, the MTIME register and the MTIMECMP array of
+ * an ACLINT MTIMER live at independent bases. A platform may have several
+ * MTIMER instances, each with its own MTIMECMP array and either its own
+ * MTIME or the MTIME of the reference instance.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_io.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi_utils/timer/aclint_mtimer.h>
+
+static struct aclint_mtimer_data *mtimer_hartid2data[SBI_HARTMASK_MAX_BITS];
+
+#if __riscv_xlen != 32
+static u64 mtimer_time_rd64(volatile u64 *addr)
+{
+	return readq_relaxed(addr);
+}
+
+static void mtimer_time_wr64(u64 value, volatile u64 *addr)
+{
+	writeq_relaxed(value, addr);
+}
+#endif
+
+static u64 mtimer_time_rd32(volatile u64 *addr)
+{
+	u32 lo, hi;
+
+	do {
+		hi = readl_relaxed((u32 *)addr + 1);
+		lo = readl_relaxed((u32 *)addr);
+	} while (hi != readl_relaxed((u32 *)addr + 1));
+
+	return ((u64)hi << 32) | (u64)lo;
+}
+
+static void mtimer_time_wr32(u64 value, volatile u64 *addr)
+{
+	u32 mask = -1U;
+
+	writel_relaxed(value & mask, (void *)(addr));
+	writel_relaxed(value >> 32, (void *)(addr) + 0x04);
+}
+
+u64 aclint_mtimer_value(void)
+{
+	struct aclint_mtimer_data *mt = mtimer_hartid2data[current_hartid()];
+
+	/* Read MTIMER Time Value */
+	return mt->time_rd(mt->time_val) + mt->time_delta;
+}
+
+void aclint_mtimer_event_stop(void)
+{
+	u32 target_hart = current_hartid();
+	struct aclint_mtimer_data *mt = mtimer_hartid2data[target_hart];
+
+	/* Clear MTIMER Time Compare */
+	mt->time_wr(-1ULL, &mt->time_cmp[target_hart - mt->first_hartid]);
+}
+
+void aclint_mtimer_event_start(u64 next_event)
+{
+	u32 target_hart = current_hartid();
+	struct aclint_mtimer_data *mt = mtimer_hartid2data[target_hart];
+
+	/* Program MTIMER Time Compare */
+	mt->time_wr(next_event - mt->time_delta,
+		    &mt->time_cmp[target_hart - mt->first_hartid]);
+}
+
+/*
+ * Compute offset of our MTIME to the reference MTIME. The reference is
+ * read between two reads of our MTIME and the sample with the smallest
+ * round trip is kept, as it bounds the error of the midpoint best.
+ */
+static u64 mtimer_time_delta(struct aclint_mtimer_data *mt,
+			     struct aclint_mtimer_data *ref)
+{
+	u32 i;
+	u64 v1, v2, mv, rtt, min_rtt = -1ULL, delta = 0;
+
+	for (i = 0; i < ACLINT_MTIMER_SYNC_ROUNDS; i++) {
+		v1 = mt->time_rd(mt->time_val);
+		mv = ref->time_rd(ref->time_val);
+		v2 = mt->time_rd(mt->time_val);
+		rtt = v2 - v1;
+		if (rtt < min_rtt) {
+			min_rtt = rtt;
+			delta = mv - (v1 + rtt / 2);
+		}
+	}
+
+	return delta;
+}
+
+int aclint_mtimer_warm_init(void)
+{
+	u32 target_hart = current_hartid();
+	struct aclint_mtimer_data *reference;
+	struct aclint_mtimer_data *mt = mtimer_hartid2data[target_hart];
+
+	if (!mt)
+		return SBI_ENODEV;
+
+	/*
+	 * Compute delta if reference available
+	 *
+	 * We deliberately compute time_delta in warm init so that time_delta
+	 * is computed on a HART which is going to use given MTIMER. We use
+	 * atomic flag time_delta_computed to ensure that only one HART does
+	 * time_delta computation.
+	 */
+	reference = mt->time_delta_reference;
+	if (reference && mt->time_val != reference->time_val &&
+	    !atomic_raw_xchg_ulong(&mt->time_delta_computed, 1))
+		mt->time_delta = mtimer_time_delta(mt, reference);
+
+	/* Clear Time Compare */
+	mt->time_wr(-1ULL, &mt->time_cmp[target_hart - mt->first_hartid]);
+
+	return 0;
+}
+
+int aclint_mtimer_cold_init(struct aclint_mtimer_data *mt,
+			    struct aclint_mtimer_data *reference)
+{
+	u32 i;
+
+	/* Sanity checks */
+	if (!mt || !mt->mtimecmp_size ||
+	    (mt->mtimecmp_addr & (ACLINT_MTIMER_ALIGN - 1)) ||
+	    (mt->mtimecmp_size < (mt->hart_count * sizeof(u64))) ||
+	    (ACLINT_MTIMER_MAX_HARTS < mt->hart_count))
+		return SBI_EINVAL;
+	if (mt->mtime_size &&
+	    (mt->mtime_addr & (ACLINT_MTIMER_ALIGN - 1)))
+		return SBI_EINVAL;
+	if (!mt->mtime_size && !reference)
+		return SBI_EINVAL;
+
+	/* Initialize private data */
+	mt->time_delta_reference = reference;
+	mt->time_delta_computed = 0;
+	mt->time_delta = 0;
+	mt->time_cmp = (u64 *)mt->mtimecmp_addr;
+	mt->time_rd = mtimer_time_rd32;
+	mt->time_wr = mtimer_time_wr32;
+
+	/* Instance without its own MTIME shares the reference MTIME */
+	if (mt->mtime_size)
+		mt->time_val = (u64 *)mt->mtime_addr;
+	else
+		mt->time_val = reference->time_val;
+
+	/* Override read/write accessors for 64bit MMIO */
+#if __riscv_xlen != 32
+	if (mt->has_64bit_mmio) {
+		mt->time_rd = mtimer_time_rd64;
+		mt->time_wr = mtimer_time_wr64;
+	}
+#endif
+
+	/* Update MTIMER hartid table */
+	for (i = 0; i < mt->hart_count; i++) {
+		if (SBI_HARTMASK_MAX_BITS <= (mt->first_hartid + i))
+			break;
+		mtimer_hartid2data[mt->first_hartid + i] = mt;
+	}
+
+	return 0;
+}
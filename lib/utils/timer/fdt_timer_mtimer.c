@@ -0,0 +1,75 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * FDT glue for RISC-V ACLINT machine-level timer (MTIMER) device.
+ */
+
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_error.h>
+#include <sbi_utils/fdt/fdt_helper.h>
+#include <sbi_utils/timer/fdt_timer.h>
+#include <sbi_utils/timer/aclint_mtimer.h>
+
+#define MTIMER_MAX_NR			16
+
+static unsigned long mtimer_count = 0;
+static struct aclint_mtimer_data mtimer[MTIMER_MAX_NR];
+
+/*
+ * The first reg entry is the MTIMECMP array and the optional second one
+ * is the MTIME register. The first instance with an MTIME register is the
+ * reference time source of all other instances.
+ */
+static int timer_mtimer_cold_init(void *fdt, int nodeoff,
+				  const struct fdt_match *match)
+{
+	int rc;
+	unsigned long i;
+	struct aclint_mtimer_data *mt, *mtmaster = NULL;
+
+	if (MTIMER_MAX_NR <= mtimer_count)
+		return SBI_ENOSPC;
+	mt = &mtimer[mtimer_count];
+
+	rc = fdt_parse_aclint_node(fdt, nodeoff, IRQ_M_TIMER,
+				   &mt->mtimecmp_addr, &mt->mtimecmp_size,
+				   &mt->first_hartid, &mt->hart_count);
+	if (rc)
+		return rc;
+
+	if (fdt_get_node_addr_size_by_index(fdt, nodeoff, 1,
+					    &mt->mtime_addr, &mt->mtime_size))
+		mt->mtime_addr = mt->mtime_size = 0;
+
+	/* TODO: We should figure-out MTIMER has_64bit_mmio from DT node */
+	mt->has_64bit_mmio = TRUE;
+
+	for (i = 0; i < mtimer_count; i++) {
+		if (mtimer[i].mtime_size) {
+			mtmaster = &mtimer[i];
+			break;
+		}
+	}
+
+	rc = aclint_mtimer_cold_init(mt, mtmaster);
+	if (rc)
+		return rc;
+	mtimer_count++;
+
+	return 0;
+}
+
+static const struct fdt_match timer_mtimer_match[] = {
+	{ .compatible = "riscv,aclint-mtimer" },
+	{ },
+};
+
+struct fdt_timer fdt_timer_mtimer = {
+	.match_table = timer_mtimer_match,
+	.cold_init = timer_mtimer_cold_init,
+	.warm_init = aclint_mtimer_warm_init,
+	.exit = NULL,
+	.value = aclint_mtimer_value,
+	.event_stop = aclint_mtimer_event_stop,
+	.event_start = aclint_mtimer_event_start,
+};
@@ -12,7 +12,11 @@
 #include <sbi/riscv_encoding.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_const.h>
+#include <sbi/sbi_csr_detect.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_ipi.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_tlb.h>
 #include <sbi_utils/fdt/fdt_fixup.h>
 #include <sbi_utils/irqchip/plic.h>
 #include <sbi_utils/serial/uart8250.h>
@@ -29,6 +33,7 @@ static struct plic_data plic = {
 	.num_src = AE350_PLIC_NUM_SOURCES,
 };
 int has_l2;
+static bool has_wfe;
 
 static int ae350_pre_init(bool cold_boot)
 {
@@ -125,6 +130,37 @@ static int ae350_early_init(bool cold_boot)
 	return 0;
 }
 
+static void ae350_wfe_probe(void)
+{
+	struct sbi_trap_info trap = {0};
+
+	csr_read_allowed(CSR_WFE, (ulong)&trap);
+	has_wfe = (trap.cause) ? FALSE : TRUE;
+}
+
+/*
+ * With WFE set, WFI also returns on an event sent by another HART
+ * through TXEVT. An event sent before WFI is remembered so it is not
+ * lost between the condition check and WFI.
+ */
+static int ae350_wait_event(void)
+{
+	if (!has_wfe)
+		return SBI_ENOTSUPP;
+
+	csr_write(CSR_WFE, 1);
+	wfi();
+	csr_write(CSR_WFE, 0);
+
+	return 0;
+}
+
+static void ae350_signal_event(void)
+{
+	if (has_wfe)
+		csr_write(CSR_TXEVT, 1);
+}
+
 /* Platform final initialization. */
 static int ae350_final_init(bool cold_boot)
 {
@@ -138,6 +174,7 @@ static int ae350_final_init(bool cold_boot)
 
 	init_pma();
 	trigger_init();
+	ae350_wfe_probe();
 
 	return 0;
 }
@@ -367,6 +404,54 @@ int ae350_enter_suspend_mode(int suspend_mode, int main_core,
 	return 0;
 }
 
+/*
+ * The *_MANY calls apply a per-HART CSR setting on all HARTs of a hart
+ * mask with one ecall instead of one ecall on every HART.
+ */
+struct ae350_pma_args {
+	unsigned long pa;
+	unsigned long va;
+	unsigned long size;
+	unsigned long entry_id;
+};
+
+static int ae350_call_mcache_ctl(void *arg)
+{
+	return mcall_set_mcache_ctl(*(unsigned long *)arg);
+}
+
+static int ae350_call_mmisc_ctl(void *arg)
+{
+	return mcall_set_mmisc_ctl(*(unsigned long *)arg);
+}
+
+static int ae350_call_set_pma(void *arg)
+{
+	struct ae350_pma_args *pma = arg;
+
+	mcall_set_pma(pma->pa, pma->va, pma->size, pma->entry_id);
+	return 0;
+}
+
+static int ae350_call_free_pma(void *arg)
+{
+	mcall_free_pma(*(unsigned long *)arg);
+	return 0;
+}
+
+static int ae350_set_pma_many(unsigned long *args)
+{
+	struct ae350_pma_args pma = {
+		.pa = args[0],
+		.va = args[1],
+		.size = args[2],
+		.entry_id = args[3],
+	};
+
+	return sbi_ipi_call_many(args[4], args[5],
+				 ae350_call_set_pma, &pma, TRUE);
+}
+
 /* Vendor-Specific SBI handler */
 static int ae350_vendor_ext_provider(long extid, long funcid,
 	unsigned long *args, unsigned long *out_value,
@@ -426,7 +511,9 @@ static int ae350_vendor_ext_provider(long extid, long funcid,
 		ae350_set_suspend_mode(args[0]);
 		break;
 	case SBI_EXT_ANDES_ENTER_SUSPEND_MODE:
+		sbi_tlb_suspend(sbi_scratch_thishart_ptr());
 		ae350_enter_suspend_mode(args[0], args[1], args[2], args[3]);
+		sbi_tlb_resume(sbi_scratch_thishart_ptr());
 		break;
 	case SBI_EXT_ANDES_RESTART:
 		mcall_restart(args[0]);
@@ -446,6 +533,21 @@ static int ae350_vendor_ext_provider(long extid, long funcid,
 	case SBI_EXT_ANDES_DCACHE_WBINVAL_ALL:
 		ret = mcall_dcache_wbinval_all();
 		break;
+	case SBI_EXT_ANDES_SET_MCACHE_CTL_MANY:
+		ret = sbi_ipi_call_many(args[1], args[2],
+					ae350_call_mcache_ctl, &args[0], TRUE);
+		break;
+	case SBI_EXT_ANDES_SET_MMISC_CTL_MANY:
+		ret = sbi_ipi_call_many(args[1], args[2],
+					ae350_call_mmisc_ctl, &args[0], TRUE);
+		break;
+	case SBI_EXT_ANDES_SET_PMA_MANY:
+		ret = ae350_set_pma_many(args);
+		break;
+	case SBI_EXT_ANDES_FREE_PMA_MANY:
+		ret = sbi_ipi_call_many(args[1], args[2],
+					ae350_call_free_pma, &args[0], TRUE);
+		break;
 	default:
 		sbi_printf("Unsupported vendor sbi call : %ld\n", funcid);
 		asm volatile("ebreak");
@@ -453,6 +555,12 @@ static int ae350_vendor_ext_provider(long extid, long funcid,
 	return ret;
 }
 
+/* Range flush crossover differs between AndesCore parts so measure it */
+static u64 ae350_get_tlbr_flush_limit(void)
+{
+	return SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_CALIBRATE;
+}
+
 /* Platform descriptor. */
 const struct sbi_platform_operations platform_ops = {
 	.pre_init   = ae350_pre_init,
@@ -465,9 +573,13 @@ const struct sbi_platform_operations platform_ops = {
 
 	.irqchip_init = ae350_irqchip_init,
 
-	.ipi_init     = ae350_ipi_init,
-	.ipi_send     = plicsw_ipi_send,
-	.ipi_clear    = plicsw_ipi_clear,
+	.ipi_init      = ae350_ipi_init,
+	.ipi_send      = plicsw_ipi_send,
+	.ipi_send_mask = plicsw_ipi_send_mask,
+	.ipi_clear     = plicsw_ipi_clear,
+
+	.wait_event   = ae350_wait_event,
+	.signal_event = ae350_signal_event,
 
 	.timer_init	   = ae350_timer_init,
 	.timer_value	   = plmt_timer_value,
@@ -476,6 +588,8 @@ const struct sbi_platform_operations platform_ops = {
 
 	.system_reset	 = ae350_system_reset,
 
+	.get_tlbr_flush_limit = ae350_get_tlbr_flush_limit,
+
 	.vendor_ext_provider = ae350_vendor_ext_provider
 };
 
@@ -156,6 +156,10 @@ enum sbi_ext_andes_fid {
 	SBI_EXT_ANDES_FREE_PMA,
 	SBI_EXT_ANDES_PROBE_PMA,
 	SBI_EXT_ANDES_DCACHE_WBINVAL_ALL,
+	SBI_EXT_ANDES_SET_MCACHE_CTL_MANY,
+	SBI_EXT_ANDES_SET_MMISC_CTL_MANY,
+	SBI_EXT_ANDES_SET_PMA_MANY,
+	SBI_EXT_ANDES_FREE_PMA_MANY,
 };
 #endif
 
@@ -10,6 +10,7 @@
 
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_io.h>
+#include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_types.h>
 #include "plicsw.h"
 #include "platform.h"
@@ -78,6 +79,28 @@ void plicsw_ipi_send(u32 target_hart)
 	plic_sw_pending(target_hart);
 }
 
+void plicsw_ipi_send_mask(ulong hmask, ulong hbase)
+{
+	ulong i;
+	u32 val = 0;
+	u32 source_hart = current_hartid();
+	u32 per_hart_offset = PLICSW_PENDING_PER_HART * source_hart;
+
+	/*
+	 * All targets are bits of the source HART's own pending region
+	 * (see plic_sw_pending()) so they are set with a single write.
+	 */
+	sbi_hmask_for_each_bit(i, hmask) {
+		if (plicsw_ipi_hart_count <= (hbase + i))
+			break;
+		val |= 1 << ((PLICSW_PENDING_PER_HART - 1) - (hbase + i));
+	}
+
+	if (val)
+		writel(val << per_hart_offset,
+		       plicsw_dev[source_hart].plicsw_pending);
+}
+
 void plicsw_ipi_clear(u32 target_hart)
 {
 	if (plicsw_ipi_hart_count <= target_hart)
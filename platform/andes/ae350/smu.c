@@ -10,6 +10,7 @@
 #include <sbi/sbi_types.h>
 #include <sbi/riscv_asm.h>
 #include <sbi/sbi_console.h>
+#include <sbi/sbi_wait.h>
 #include <sbi/riscv_io.h>
 #include "smu.h"
 #include "platform.h"
@@ -92,7 +93,10 @@ void smu_check_pcs_status(int sleep_mode_status, int num_cpus)
 	int ready_cpu[AE350_HART_COUNT] = {0};
 	u32 hartid = current_hartid();
 	u32 cpu, status, type;
+	struct sbi_wait w;
 
+	/* Power state changes do not signal events so only back off */
+	SBI_WAIT_INIT(&w, FALSE);
 	while (ready_cnt) {
 		for (cpu = 0; cpu < num_cpus; cpu++) {
 			if (cpu == hartid || ready_cpu[cpu] == 1)
@@ -106,6 +110,8 @@ void smu_check_pcs_status(int sleep_mode_status, int num_cpus)
 				ready_cpu[cpu] = 1;
 			}
 		}
+		if (ready_cnt)
+			sbi_wait_relax(&w);
 	}
 }
 
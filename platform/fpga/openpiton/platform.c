@@ -173,6 +173,20 @@ static int openpiton_timer_init(bool cold_boot)
 	return clint_warm_timer_init();
 }
 
+/*
+ * Get the cluster of a HART from the FDT cpu-map.
+ */
+static u32 openpiton_hart_cluster(u32 hartid)
+{
+	u32 cluster_hartid;
+	void *fdt = sbi_scratch_thishart_arg1_ptr();
+
+	if (fdt_parse_hart_cluster(fdt, hartid, &cluster_hartid))
+		return hartid;
+
+	return cluster_hartid;
+}
+
 /*
  * Reset the openpiton.
  */
@@ -195,11 +209,13 @@ const struct sbi_platform_operations platform_ops = {
 	.irqchip_init = openpiton_irqchip_init,
 	.ipi_init = openpiton_ipi_init,
 	.ipi_send = clint_ipi_send,
+	.ipi_send_mask = clint_ipi_send_mask,
 	.ipi_clear = clint_ipi_clear,
 	.timer_init = openpiton_timer_init,
 	.timer_value = clint_timer_value,
 	.timer_event_start = clint_timer_event_start,
 	.timer_event_stop = clint_timer_event_stop,
+	.get_hart_cluster = openpiton_hart_cluster,
 	.system_reset = openpiton_system_reset
 };
 
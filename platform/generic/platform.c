@@ -175,6 +175,17 @@ static u64 generic_tlbr_flush_limit(void)
 	return SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_DEFAULT;
 }
 
+static u32 generic_hart_cluster(u32 hartid)
+{
+	u32 cluster_hartid;
+	void *fdt = sbi_scratch_thishart_arg1_ptr();
+
+	if (fdt_parse_hart_cluster(fdt, hartid, &cluster_hartid))
+		return hartid;
+
+	return cluster_hartid;
+}
+
 static int generic_system_reset(u32 reset_type)
 {
 	if (generic_plat && generic_plat->system_reset)
@@ -194,10 +205,13 @@ const struct sbi_platform_operations platform_ops = {
 	.irqchip_init		= fdt_irqchip_init,
 	.irqchip_exit		= fdt_irqchip_exit,
 	.ipi_send		= fdt_ipi_send,
+	.ipi_send_mask		= fdt_ipi_send_mask,
 	.ipi_clear		= fdt_ipi_clear,
+	.ipi_smode_send		= fdt_ipi_smode_send,
 	.ipi_init		= fdt_ipi_init,
 	.ipi_exit		= fdt_ipi_exit,
 	.get_tlbr_flush_limit	= generic_tlbr_flush_limit,
+	.get_hart_cluster	= generic_hart_cluster,
 	.timer_value		= fdt_timer_value,
 	.timer_event_stop	= fdt_timer_event_stop,
 	.timer_event_start	= fdt_timer_event_start,
@@ -31,9 +31,27 @@ platform-ldflags-y =
 # PLATFORM_RISCV_ISA = rv64imafdc
 # PLATFORM_RISCV_CODE_MODEL = medany
 
+#
+# Maximum HART id + 1 supported by the platform. This is an optional
+# parameter and defaults to 128.
+#
+# PLATFORM_HART_COUNT_MAX = 1024
+
 # Firmware load address configuration. This is mandatory.
 FW_TEXT_START=0x80000000
 
+#
+# Vectored MTVEC mode with dedicated interrupt entry points. This is an
+# optional parameter and defaults to direct mode.
+#
+# FW_TRAP_VECTORED=y
+
+#
+# Experimental trap fast path for the SBI set_timer call. This is an
+# optional parameter and defaults to disabled.
+#
+# FW_TRAP_FAST_SET_TIMER=y
+
 #
 # Dynamic firmware configuration.
 # Optional parameters are commented out. Uncomment and define these parameters
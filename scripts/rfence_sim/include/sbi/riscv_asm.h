@@ -0,0 +1,43 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host replacement of the CSR accessors. The simulated CSRs are kept
+ * per host thread, one thread being one HART.
+ */
+
+#ifndef __SIM_RISCV_ASM_H__
+#define __SIM_RISCV_ASM_H__
+
+#include_next <sbi/riscv_asm.h>
+
+#ifndef __ASSEMBLY__
+
+unsigned long sim_csr_read(int csr);
+unsigned long sim_csr_swap(int csr, unsigned long val);
+unsigned long sim_csr_read_set(int csr, unsigned long val);
+unsigned long sim_csr_read_clear(int csr, unsigned long val);
+void sim_host_relax(void);
+
+#undef csr_swap
+#undef csr_read
+#undef csr_write
+#undef csr_read_set
+#undef csr_set
+#undef csr_read_clear
+#undef csr_clear
+#undef wfi
+
+#define csr_swap(csr, val)	sim_csr_swap(csr, (unsigned long)(val))
+#define csr_read(csr)		sim_csr_read(csr)
+#define csr_write(csr, val)	((void)sim_csr_swap(csr, (unsigned long)(val)))
+#define csr_read_set(csr, val)	sim_csr_read_set(csr, (unsigned long)(val))
+#define csr_set(csr, val)	((void)sim_csr_read_set(csr, (unsigned long)(val)))
+#define csr_read_clear(csr, val) \
+	sim_csr_read_clear(csr, (unsigned long)(val))
+#define csr_clear(csr, val)	\
+	((void)sim_csr_read_clear(csr, (unsigned long)(val)))
+#define wfi()			sim_host_relax()
+
+#endif /* !__ASSEMBLY__ */
+
+#endif
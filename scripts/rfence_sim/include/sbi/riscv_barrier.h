@@ -0,0 +1,16 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host replacement of the RISC-V fences. Every fence is a full host
+ * fence, which is at least as strong as the RISC-V one it replaces.
+ */
+
+#ifndef __SIM_RISCV_BARRIER_H__
+#define __SIM_RISCV_BARRIER_H__
+
+#include_next <sbi/riscv_barrier.h>
+
+#undef RISCV_FENCE
+#define RISCV_FENCE(p, s)	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif
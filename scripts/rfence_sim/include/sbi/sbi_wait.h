@@ -0,0 +1,22 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host replacement of the pause hint. Simulated HARTs usually outnumber
+ * host CPUs, so a waiting HART gives up its CPU instead of spinning.
+ */
+
+#ifndef __SIM_SBI_WAIT_H__
+#define __SIM_SBI_WAIT_H__
+
+#define sbi_cpu_relax		sbi_cpu_relax_riscv
+#include_next <sbi/sbi_wait.h>
+#undef sbi_cpu_relax
+
+void sim_host_relax(void);
+
+static inline void sbi_cpu_relax(void)
+{
+	sim_host_relax();
+}
+
+#endif
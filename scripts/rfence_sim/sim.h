@@ -0,0 +1,41 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Interface between the host side of the rfence simulator and the
+ * OpenSBI side. Only plain C types are used here because the two sides
+ * can not include each other's headers.
+ */
+
+#ifndef __SIM_H__
+#define __SIM_H__
+
+/* Request types, same values as enum sbi_tlb_info_types */
+#define SIM_FLUSH_VMA			0
+#define SIM_FLUSH_VMA_ASID		1
+#define SIM_FLUSH_GVMA			2
+#define SIM_FLUSH_GVMA_VMID		3
+#define SIM_FLUSH_VVMA			4
+#define SIM_FLUSH_VVMA_ASID		5
+#define SIM_ITLB_FLUSH			6
+
+/* Same value as SBI_TLB_FLUSH_ALL */
+#define SIM_FLUSH_ALL			((unsigned long)-1)
+
+/* Implemented by the OpenSBI side */
+int sim_sbi_setup(unsigned int hart_count, unsigned int cluster_size,
+		  unsigned long flush_limit, int svinval);
+int sim_sbi_boot(unsigned int hartid, int cold_boot);
+void sim_sbi_poll(void);
+int sim_sbi_rfence(unsigned long hmask, unsigned long hbase,
+		   unsigned long type, unsigned long start,
+		   unsigned long size, unsigned long asid,
+		   unsigned long vmid);
+void sim_sbi_fence_counts(unsigned long *ordered, unsigned long *inval);
+
+/* Implemented by the host side */
+void *sim_host_zalloc(unsigned long size);
+unsigned long sim_host_now(void);
+void sim_host_relax(void);
+int sim_host_vprintf(const char *fmt, __builtin_va_list args);
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Included ahead of every OpenSBI source of the simulator. The local
+ * TLB and I-cache maintenance instructions are not modelled. On x86-64
+ * hosts sfence.vma bumps the ordered fence count of sim_sbi.c, other
+ * hosts and fence.i assemble it to nothing.
+ */
+
+#ifndef __SIM_ASM_H__
+#define __SIM_ASM_H__
+
+#ifdef __x86_64__
+__asm__(".macro sfence.vma args:vararg\n"
+	"lock incq sim_fence_ordered(%rip)\n"
+	".endm\n");
+#else
+__asm__(".macro sfence.vma args:vararg\n"
+	".endm\n");
+#endif
+
+__asm__(".macro fence.i\n"
+	".endm\n");
+
+#endif
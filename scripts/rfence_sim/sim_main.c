@@ -0,0 +1,289 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host side of the rfence simulator. Every simulated HART is a thread
+ * which issues a mixed stream of remote fence requests and handles the
+ * IPIs sent to it in between. Each HART count runs in its own child
+ * process because the OpenSBI side can only be initialized once.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "sim.h"
+
+#define SIM_HARTS_MAX		128
+#define SIM_PAGE_SIZE		4096UL
+
+static unsigned int sim_iterations = 500;
+static unsigned int sim_cluster_size;
+static unsigned long sim_flush_limit;
+static int sim_svinval;
+static unsigned long sim_seed = 1;
+
+static unsigned int sim_hart_count;
+static pthread_barrier_t sim_boot_barrier;
+static pthread_barrier_t sim_cold_barrier;
+static volatile unsigned int sim_done;
+static unsigned long sim_start, sim_end;
+static unsigned long *sim_latency;
+
+void *sim_host_zalloc(unsigned long size)
+{
+	return calloc(1, size);
+}
+
+unsigned long sim_host_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+void sim_host_relax(void)
+{
+	sched_yield();
+}
+
+int sim_host_vprintf(const char *fmt, va_list args)
+{
+	return vprintf(fmt, args);
+}
+
+static unsigned long sim_rand(unsigned long *state)
+{
+	unsigned long x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+
+	return x;
+}
+
+/*
+ * Issue one request of the mixed workload. Ranged ASID flushes
+ * dominate, as they do for a running Linux kernel.
+ */
+static int sim_request(unsigned long *rs)
+{
+	unsigned long hmask, hbase, type, start, size, asid, vmid;
+	unsigned long r = sim_rand(rs);
+	unsigned long pick = r % 100;
+
+	start = (sim_rand(rs) % 1024) * SIM_PAGE_SIZE;
+	size = (1 + (r >> 8) % 8) * SIM_PAGE_SIZE;
+	asid = 1 + (r >> 16) % 16;
+	vmid = 1 + (r >> 20) % 4;
+
+	if (pick < 50) {
+		type = SIM_FLUSH_VMA_ASID;
+	} else if (pick < 65) {
+		type = SIM_FLUSH_VMA_ASID;
+		start = 0;
+		size = SIM_FLUSH_ALL;
+	} else if (pick < 75) {
+		type = SIM_FLUSH_VMA;
+		start = 0;
+		size = SIM_FLUSH_ALL;
+	} else if (pick < 85) {
+		type = SIM_ITLB_FLUSH;
+	} else if (pick < 95) {
+		type = SIM_FLUSH_GVMA_VMID;
+	} else {
+		type = SIM_FLUSH_VVMA_ASID;
+	}
+
+	/* Broadcast or a neighbourhood of up to eight HARTs */
+	if ((r >> 24) % 5 < 2) {
+		hbase = -1UL;
+		hmask = 0;
+	} else {
+		hbase = (r >> 32) % sim_hart_count;
+		hmask = (r >> 40) & 0xff;
+	}
+
+	return sim_sbi_rfence(hmask, hbase, type, start, size, asid, vmid);
+}
+
+static void *sim_hart_main(void *arg)
+{
+	int rc;
+	unsigned int i, hartid = (unsigned long)arg;
+	unsigned long t, rs = sim_seed * 0x9e3779b97f4a7c15UL + hartid + 1;
+	unsigned long *lat = &sim_latency[hartid * sim_iterations];
+
+	if (hartid)
+		pthread_barrier_wait(&sim_cold_barrier);
+	rc = sim_sbi_boot(hartid, !hartid);
+	if (!hartid)
+		pthread_barrier_wait(&sim_cold_barrier);
+	if (rc) {
+		fprintf(stderr, "hart%u: boot failed (error %d)\n",
+			hartid, rc);
+		exit(1);
+	}
+
+	pthread_barrier_wait(&sim_boot_barrier);
+	if (!hartid)
+		sim_start = sim_host_now();
+
+	for (i = 0; i < sim_iterations; i++) {
+		sim_sbi_poll();
+		t = sim_host_now();
+		rc = sim_request(&rs);
+		lat[i] = sim_host_now() - t;
+		if (rc) {
+			fprintf(stderr, "hart%u: request failed (error %d)\n",
+				hartid, rc);
+			exit(1);
+		}
+	}
+
+	/* Keep serving the other HARTs until all of them are done */
+	if (__atomic_add_fetch(&sim_done, 1, __ATOMIC_SEQ_CST) ==
+	    sim_hart_count)
+		sim_end = sim_host_now();
+	while (__atomic_load_n(&sim_done, __ATOMIC_SEQ_CST) < sim_hart_count) {
+		sim_sbi_poll();
+		sim_host_relax();
+	}
+	sim_sbi_poll();
+
+	return NULL;
+}
+
+static int sim_cmp(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *)a;
+	unsigned long y = *(const unsigned long *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int sim_run(unsigned int hart_count)
+{
+	int rc;
+	unsigned int i;
+	unsigned long total, elapsed, ordered, inval;
+	pthread_t threads[SIM_HARTS_MAX];
+
+	sim_hart_count = hart_count;
+	total = (unsigned long)hart_count * sim_iterations;
+	sim_latency = calloc(total, sizeof(*sim_latency));
+	if (!sim_latency)
+		return ENOMEM;
+
+	rc = sim_sbi_setup(hart_count, sim_cluster_size,
+			   sim_flush_limit * SIM_PAGE_SIZE, sim_svinval);
+	if (rc) {
+		fprintf(stderr, "setup failed (error %d)\n", rc);
+		return 1;
+	}
+
+	pthread_barrier_init(&sim_cold_barrier, NULL, hart_count);
+	pthread_barrier_init(&sim_boot_barrier, NULL, hart_count);
+	for (i = 0; i < hart_count; i++) {
+		rc = pthread_create(&threads[i], NULL, sim_hart_main,
+				    (void *)(unsigned long)i);
+		if (rc)
+			return rc;
+	}
+	for (i = 0; i < hart_count; i++)
+		pthread_join(threads[i], NULL);
+
+	qsort(sim_latency, total, sizeof(*sim_latency), sim_cmp);
+	elapsed = sim_end - sim_start;
+	sim_sbi_fence_counts(&ordered, &inval);
+	printf("%5u %10lu %10.1f %12.0f %10.2f %10.2f %9.2f %9.2f\n",
+	       hart_count, total, elapsed / 1e6, total / (elapsed / 1e9),
+	       sim_latency[total / 2] / 1e3,
+	       sim_latency[total * 99 / 100] / 1e3,
+	       (double)ordered / total, (double)inval / total);
+
+	return 0;
+}
+
+static void sim_usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-i iterations] [-c cluster_size] [-l pages] [-v] "
+		"[-s seed] [harts ...]\n"
+		"  -i  requests issued by every HART (default %u)\n"
+		"  -c  HARTs per relay cluster, 0 or 1 disables relaying\n"
+		"  -l  range flush limit in pages (default platform default)\n"
+		"  -v  HARTs have Svinval\n"
+		"  -s  seed of the request stream (default %lu)\n"
+		"  HART counts default to 2 4 8 16 32 64 128, at most %u\n",
+		prog, sim_iterations, sim_seed, SIM_HARTS_MAX);
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	int o, i, status;
+	unsigned int n, counts[32], count_num = 0;
+	pid_t pid;
+
+	while ((o = getopt(argc, argv, "i:c:l:vs:h")) != -1) {
+		switch (o) {
+		case 'i':
+			sim_iterations = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			sim_cluster_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			sim_flush_limit = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			sim_svinval = 1;
+			break;
+		case 's':
+			sim_seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			sim_usage(argv[0]);
+		}
+	}
+	if (!sim_iterations)
+		sim_usage(argv[0]);
+
+	for (i = optind; i < argc && count_num < 32; i++) {
+		n = strtoul(argv[i], NULL, 0);
+		if (n < 1 || SIM_HARTS_MAX < n)
+			sim_usage(argv[0]);
+		counts[count_num++] = n;
+	}
+	if (!count_num) {
+		for (n = 2; n <= SIM_HARTS_MAX; n <<= 1)
+			counts[count_num++] = n;
+	}
+
+	printf("%5s %10s %10s %12s %10s %10s %9s %9s\n", "harts", "requests",
+	       "time_ms", "requests/s", "p50_us", "p99_us", "ord/req",
+	       "inval/req");
+	fflush(stdout);
+
+	for (i = 0; i < count_num; i++) {
+		pid = fork();
+		if (pid < 0)
+			return 1;
+		if (!pid)
+			exit(sim_run(counts[i]));
+		if (waitpid(pid, &status, 0) < 0 ||
+		    !WIFEXITED(status) || WEXITSTATUS(status))
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,529 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * OpenSBI side of the rfence simulator. It provides the platform, the
+ * CSRs, the atomics, the locks and the HSM state used by sbi_tlb.c and
+ * sbi_ipi.c, which are linked in unmodified.
+ */
+
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_hfence.h>
+#include <sbi/sbi_hsm.h>
+#include <sbi/sbi_ipi.h>
+#include <sbi/sbi_platform.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_tlb.h>
+#include <sbi/sbi_wait.h>
+#include "sim.h"
+
+/** State of one simulated HART */
+struct sim_hart {
+	/** Scratch space of the HART */
+	struct sbi_scratch *scratch;
+	/** Machine software interrupt pending bit */
+	unsigned long msip;
+	/** Simulated MIP and MIE CSRs */
+	unsigned long mip;
+	unsigned long mie;
+};
+
+static struct sim_hart *sim_harts;
+static unsigned int sim_cluster_size;
+static unsigned long sim_flush_limit;
+static bool sim_svinval;
+static struct sbi_hartmask sim_started_mask;
+static __thread u32 sim_hartid;
+
+static void sim_ipi_send(u32 target_hart)
+{
+	__atomic_store_n(&sim_harts[target_hart].msip, 1, __ATOMIC_RELEASE);
+}
+
+static void sim_ipi_clear(u32 target_hart)
+{
+	__atomic_store_n(&sim_harts[target_hart].msip, 0, __ATOMIC_RELEASE);
+}
+
+static u32 sim_get_hart_cluster(u32 hartid)
+{
+	return hartid - (hartid % sim_cluster_size);
+}
+
+static u64 sim_timer_value(void)
+{
+	return sim_host_now();
+}
+
+static u64 sim_get_tlbr_flush_limit(void)
+{
+	return sim_flush_limit;
+}
+
+static struct sbi_platform_operations sim_platform_ops = {
+	.ipi_send		= sim_ipi_send,
+	.ipi_clear		= sim_ipi_clear,
+	.timer_value		= sim_timer_value,
+};
+
+static struct sbi_platform sim_platform = {
+	.name			= "rfence-sim",
+	.hart_stack_size	= 0,
+	.platform_ops_addr	= (unsigned long)&sim_platform_ops,
+};
+
+static struct sbi_scratch *sim_hartid_to_scratch(ulong hartid,
+						 ulong hartindex)
+{
+	return sim_harts[hartid].scratch;
+}
+
+int sim_sbi_setup(unsigned int hart_count, unsigned int cluster_size,
+		  unsigned long flush_limit, int svinval)
+{
+	u32 i;
+
+	if (!hart_count || SBI_HARTMASK_MAX_BITS < hart_count)
+		return SBI_EINVAL;
+
+	sim_harts = sim_host_zalloc(hart_count * sizeof(*sim_harts));
+	if (!sim_harts)
+		return SBI_ENOMEM;
+
+	for (i = 0; i < hart_count; i++) {
+		sim_harts[i].scratch = sim_host_zalloc(SBI_SCRATCH_SIZE);
+		if (!sim_harts[i].scratch)
+			return SBI_ENOMEM;
+		sim_harts[i].scratch->platform_addr =
+				(unsigned long)&sim_platform;
+		sim_harts[i].scratch->hartid_to_scratch =
+				(unsigned long)sim_hartid_to_scratch;
+	}
+
+	sim_platform.hart_count = hart_count;
+	if (1 < cluster_size) {
+		sim_cluster_size = cluster_size;
+		sim_platform_ops.get_hart_cluster = sim_get_hart_cluster;
+	}
+	if (flush_limit) {
+		sim_flush_limit = flush_limit;
+		sim_platform_ops.get_tlbr_flush_limit =
+					sim_get_tlbr_flush_limit;
+	}
+	sim_svinval = svinval ? TRUE : FALSE;
+
+	return sbi_scratch_init(sim_harts[0].scratch);
+}
+
+int sim_sbi_boot(unsigned int hartid, int cold_boot)
+{
+	int rc;
+	struct sbi_scratch *scratch = sim_harts[hartid].scratch;
+
+	sim_hartid = hartid;
+
+	rc = sbi_ipi_init(scratch, cold_boot);
+	if (rc)
+		return rc;
+
+	rc = sbi_tlb_init(scratch, cold_boot);
+	if (rc)
+		return rc;
+
+	atomic_raw_set_bit(hartid, sbi_hartmask_bits(&sim_started_mask));
+
+	return 0;
+}
+
+void sim_sbi_poll(void)
+{
+	if (__atomic_load_n(&sim_harts[sim_hartid].msip, __ATOMIC_ACQUIRE))
+		sbi_ipi_process();
+}
+
+int sim_sbi_rfence(unsigned long hmask, unsigned long hbase,
+		   unsigned long type, unsigned long start,
+		   unsigned long size, unsigned long asid,
+		   unsigned long vmid)
+{
+	struct sbi_tlb_info tinfo;
+
+	SBI_TLB_INFO_INIT(&tinfo, start, size, asid, vmid, type, sim_hartid);
+
+	return sbi_tlb_request(hmask, hbase, &tinfo);
+}
+
+/* CSRs */
+
+unsigned long sim_csr_read(int csr)
+{
+	return sim_csr_read_set(csr, 0);
+}
+
+unsigned long sim_csr_swap(int csr, unsigned long val)
+{
+	unsigned long old;
+	struct sim_hart *h = &sim_harts[sim_hartid];
+
+	switch (csr) {
+	case CSR_MIP:
+		old = h->mip;
+		h->mip = val;
+		return old;
+	case CSR_MIE:
+		old = h->mie;
+		h->mie = val;
+		return old;
+	default:
+		return sim_csr_read(csr);
+	}
+}
+
+unsigned long sim_csr_read_set(int csr, unsigned long val)
+{
+	unsigned long old;
+	struct sim_hart *h = &sim_harts[sim_hartid];
+
+	switch (csr) {
+	case CSR_MHARTID:
+		return sim_hartid;
+	case CSR_MSCRATCH:
+		return (unsigned long)h->scratch;
+	case CSR_MCYCLE:
+	case CSR_TIME:
+		return sim_host_now();
+	case CSR_MIP:
+		old = h->mip;
+		h->mip |= val;
+		return old;
+	case CSR_MIE:
+		old = h->mie;
+		h->mie |= val;
+		return old;
+	default:
+		return 0;
+	}
+}
+
+unsigned long sim_csr_read_clear(int csr, unsigned long val)
+{
+	unsigned long old;
+	struct sim_hart *h = &sim_harts[sim_hartid];
+
+	switch (csr) {
+	case CSR_MIP:
+		old = h->mip;
+		h->mip &= ~val;
+		return old;
+	case CSR_MIE:
+		old = h->mie;
+		h->mie &= ~val;
+		return old;
+	default:
+		return sim_csr_read(csr);
+	}
+}
+
+/* Atomics */
+
+long atomic_read(atomic_t *atom)
+{
+	return __atomic_load_n(&atom->counter, __ATOMIC_SEQ_CST);
+}
+
+void atomic_write(atomic_t *atom, long value)
+{
+	__atomic_store_n(&atom->counter, value, __ATOMIC_SEQ_CST);
+}
+
+long atomic_add_return(atomic_t *atom, long value)
+{
+	return __atomic_add_fetch(&atom->counter, value, __ATOMIC_SEQ_CST);
+}
+
+long atomic_sub_return(atomic_t *atom, long value)
+{
+	return __atomic_sub_fetch(&atom->counter, value, __ATOMIC_SEQ_CST);
+}
+
+long atomic_cmpxchg(atomic_t *atom, long oldval, long newval)
+{
+	__atomic_compare_exchange_n(&atom->counter, &oldval, newval, 0,
+				    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return oldval;
+}
+
+long atomic_xchg(atomic_t *atom, long newval)
+{
+	return __atomic_exchange_n(&atom->counter, newval, __ATOMIC_SEQ_CST);
+}
+
+unsigned int atomic_raw_xchg_uint(volatile unsigned int *ptr,
+				  unsigned int newval)
+{
+	return __atomic_exchange_n(ptr, newval, __ATOMIC_SEQ_CST);
+}
+
+unsigned long atomic_raw_xchg_ulong(volatile unsigned long *ptr,
+				    unsigned long newval)
+{
+	return __atomic_exchange_n(ptr, newval, __ATOMIC_SEQ_CST);
+}
+
+unsigned long atomic_raw_cmpxchg_ulong(volatile unsigned long *ptr,
+				       unsigned long oldval,
+				       unsigned long newval)
+{
+	__atomic_compare_exchange_n(ptr, &oldval, newval, 0,
+				    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return oldval;
+}
+
+int atomic_set_bit(int nr, atomic_t *atom)
+{
+	return atomic_raw_set_bit(nr, (unsigned long *)&atom->counter);
+}
+
+int atomic_clear_bit(int nr, atomic_t *atom)
+{
+	return atomic_raw_clear_bit(nr, (unsigned long *)&atom->counter);
+}
+
+unsigned long atomic_raw_set_bit(int nr, volatile unsigned long *addr)
+{
+	return __atomic_fetch_or(&addr[BIT_WORD(nr)], BIT_MASK(nr),
+				 __ATOMIC_SEQ_CST);
+}
+
+unsigned long atomic_raw_clear_bit(int nr, volatile unsigned long *addr)
+{
+	return __atomic_fetch_and(&addr[BIT_WORD(nr)], ~BIT_MASK(nr),
+				  __ATOMIC_SEQ_CST);
+}
+
+unsigned long atomic_raw_fetch_or_ulong(unsigned long mask,
+					volatile unsigned long *addr)
+{
+	return __atomic_fetch_or(addr, mask, __ATOMIC_SEQ_CST);
+}
+
+/* Ticket locks */
+
+int spin_lock_check(spinlock_t *lock)
+{
+	spinlock_t l;
+
+	*(u32 *)&l = __atomic_load_n((u32 *)lock, __ATOMIC_ACQUIRE);
+
+	return l.owner != l.next;
+}
+
+int spin_trylock(spinlock_t *lock)
+{
+	u32 l0 = __atomic_load_n((u32 *)lock, __ATOMIC_RELAXED);
+
+	if ((l0 >> TICKET_SHIFT) != (l0 & 0xffff))
+		return 0;
+
+	return __atomic_compare_exchange_n((u32 *)lock, &l0,
+					   l0 + (1U << TICKET_SHIFT), 0,
+					   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+void spin_lock(spinlock_t *lock)
+{
+	struct sbi_wait w;
+	u32 l0 = __atomic_fetch_add((u32 *)lock, 1U << TICKET_SHIFT,
+				    __ATOMIC_ACQUIRE);
+	u16 ticket = l0 >> TICKET_SHIFT;
+
+	SBI_WAIT_INIT(&w, TRUE);
+	while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket)
+		sbi_wait_relax(&w);
+}
+
+void spin_unlock(spinlock_t *lock)
+{
+	__atomic_store_n(&lock->owner, lock->owner + 1, __ATOMIC_RELEASE);
+}
+
+/* HSM */
+
+bool sbi_hsm_hart_started(u32 hartid)
+{
+	return sbi_hartmask_test_hart(hartid, &sim_started_mask);
+}
+
+int sbi_hsm_hart_started_mask(ulong hbase, ulong *out_hmask)
+{
+	ulong word = BIT_WORD(hbase), shift = hbase % BITS_PER_LONG;
+	ulong hcount = sbi_scratch_last_hartid() + 1;
+	volatile unsigned long *bits = sbi_hartmask_bits(&sim_started_mask);
+
+	*out_hmask = 0;
+	if (hcount <= hbase || SBI_HARTMASK_MAX_BITS <= hbase)
+		return SBI_EINVAL;
+
+	*out_hmask = bits[word] >> shift;
+	if (shift && (word + 1) < BITS_TO_LONGS(SBI_HARTMASK_MAX_BITS))
+		*out_hmask |= bits[word + 1] << (BITS_PER_LONG - shift);
+	if ((hcount - hbase) < BITS_PER_LONG)
+		*out_hmask &= (1UL << (hcount - hbase)) - 1;
+
+	return 0;
+}
+
+int sbi_hsm_hart_stop(struct sbi_scratch *scratch, bool exitnow)
+{
+	return SBI_ENOTSUPP;
+}
+
+/* Platform, HART features, timer and console */
+
+u32 sbi_platform_hart_index(const struct sbi_platform *plat, u32 hartid)
+{
+	return hartid;
+}
+
+int misa_extension_imp(char ext)
+{
+	return ext == 'S' || ext == 'H';
+}
+
+bool sbi_hart_has_feature(struct sbi_scratch *scratch, unsigned long feature)
+{
+	if (feature == SBI_HART_HAS_SVINVAL)
+		return sim_svinval;
+
+	return FALSE;
+}
+
+u64 sbi_timer_value(void)
+{
+	return sim_host_now();
+}
+
+int sbi_printf(const char *format, ...)
+{
+	int ret;
+	__builtin_va_list args;
+
+	__builtin_va_start(args, format);
+	ret = sim_host_vprintf(format, args);
+	__builtin_va_end(args);
+
+	return ret;
+}
+
+int sbi_dprintf(const char *format, ...)
+{
+	return 0;
+}
+
+/*
+ * Local fences are not modelled, they are only counted. Fully ordered
+ * fences and the Svinval ordering fences go to sim_fence_ordered, the
+ * Svinval invalidations which do not order anything go to
+ * sim_fence_inval. sfence.vma is counted by its sim_asm.h macro.
+ */
+
+unsigned long sim_fence_ordered;
+static unsigned long sim_fence_inval;
+
+static void sim_fence(unsigned long *count)
+{
+	__atomic_add_fetch(count, 1, __ATOMIC_RELAXED);
+}
+
+void sim_sbi_fence_counts(unsigned long *ordered, unsigned long *inval)
+{
+	*ordered = __atomic_load_n(&sim_fence_ordered, __ATOMIC_RELAXED);
+	*inval = __atomic_load_n(&sim_fence_inval, __ATOMIC_RELAXED);
+}
+
+
+void __sbi_hfence_gvma_vmid_gpa(unsigned long vmid, unsigned long gpa)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_hfence_gvma_vmid(unsigned long vmid)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_hfence_gvma_gpa(unsigned long gpa)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_hfence_gvma_all(void)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_hfence_vvma_asid_va(unsigned long asid, unsigned long va)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_hfence_vvma_asid(unsigned long asid)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_hfence_vvma_va(unsigned long va)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_hfence_vvma_all(void)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_sfence_w_inval(void)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_sfence_inval_ir(void)
+{
+	sim_fence(&sim_fence_ordered);
+}
+
+void __sbi_sinval_vma_asid_va(unsigned long asid, unsigned long va)
+{
+	sim_fence(&sim_fence_inval);
+}
+
+void __sbi_sinval_vma_va(unsigned long va)
+{
+	sim_fence(&sim_fence_inval);
+}
+
+void __sbi_hinval_gvma_vmid_gpa(unsigned long vmid, unsigned long gpa)
+{
+	sim_fence(&sim_fence_inval);
+}
+
+void __sbi_hinval_gvma_gpa(unsigned long gpa)
+{
+	sim_fence(&sim_fence_inval);
+}
+
+void __sbi_hinval_vvma_asid_va(unsigned long asid, unsigned long va)
+{
+	sim_fence(&sim_fence_inval);
+}
+
+void __sbi_hinval_vvma_va(unsigned long va)
+{
+	sim_fence(&sim_fence_inval);
+}